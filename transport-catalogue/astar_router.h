@@ -0,0 +1,117 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Поиск кратчайшего пути A* между парой вершин.
+// Эвристика должна быть нижней оценкой веса пути от вершины до цели,
+// тогда найденный путь совпадает с путём алгоритма Дейкстры.
+template <typename Weight>
+class AStarRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+    using Heuristic = std::function<Weight(VertexId vertex, VertexId target)>;
+
+    AStarRouter(const Graph& graph, Heuristic heuristic);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+private:
+    // Оценка полного пути, вес от начала и вершина
+    using QueueItem = std::tuple<Weight, Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    Heuristic heuristic_;
+};
+
+template <typename Weight>
+AStarRouter<Weight>::AStarRouter(const Graph& graph, Heuristic heuristic)
+    : graph_(graph)
+    , heuristic_(std::move(heuristic))
+{
+    if (graph.HasNegativeWeights()) {
+        throw std::domain_error("Edges' weights should be non-negative");
+    }
+}
+
+template <typename Weight>
+std::optional<typename AStarRouter<Weight>::RouteInfo>
+AStarRouter<Weight>::BuildRoute(VertexId from, VertexId to) const
+{
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    std::vector<std::optional<Weight>> weights(vertex_count);
+    std::vector<std::optional<EdgeId>> prev_edges(vertex_count);
+    // Эвристика считается не больше одного раза на вершину
+    std::vector<std::optional<Weight>> estimates(vertex_count);
+    const auto estimate = [&](VertexId vertex) {
+        auto& value = estimates[vertex];
+        if (!value) {
+            value = heuristic_(vertex, to);
+        }
+        return *value;
+    };
+
+    Queue queue;
+    weights[from] = ZERO_WEIGHT;
+    queue.emplace(estimate(from), ZERO_WEIGHT, from);
+
+    // Вершина может быть извлечена повторно, если её вес улучшился:
+    // так путь остаётся оптимальным и при не вполне согласованной эвристике
+    while (!queue.empty()) {
+        const Weight weight = std::get<1>(queue.top());
+        const VertexId vertex = std::get<2>(queue.top());
+        queue.pop();
+        if (weight != *weights[vertex]) {
+            continue;
+        }
+        if (vertex == to) {
+            break;
+        }
+        graph_.ForEachIncidentEdge(vertex, [&](EdgeId edge_id, const Edge<Weight>& edge) {
+            const Weight candidate_weight = weight + edge.weight;
+            auto& weight_to = weights[edge.to];
+            if (!weight_to || candidate_weight < *weight_to) {
+                weight_to = candidate_weight;
+                prev_edges[edge.to] = edge_id;
+                queue.emplace(candidate_weight + estimate(edge.to), candidate_weight, edge.to);
+            }
+        });
+    }
+
+    if (!weights[to]) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = prev_edges[to];
+         edge_id;
+         edge_id = prev_edges[graph_.GetEdge(*edge_id).from])
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{*weights[to], std::move(edges)};
+}
+
+}  // namespace graph
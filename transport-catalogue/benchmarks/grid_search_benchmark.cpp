@@ -0,0 +1,109 @@
+#include "bidirectional_dijkstra_router.h"
+#include "dijkstra_router.h"
+#include "graph.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Сравнивает одно- и двунаправленный поиск Дейкстры на квадратной решётке
+// со случайными весами рёбер: для одних и тех же случайных пар вершин
+// выводит среднее число окончательно обработанных вершин и время поиска.
+// Решётка и запросы зависят только от зерна, поэтому числа воспроизводимы.
+// Запуск: grid_search_benchmark [сторона решётки] [число запросов] [зерно]
+
+using namespace std::string_view_literals;
+
+namespace {
+
+using Graph = graph::DirectedWeightedGraph<double>;
+
+// Соседние узлы решётки связаны рёбрами в обе стороны
+Graph MakeGrid(size_t side, std::mt19937& generator) {
+    std::uniform_int_distribution<int> weight_distribution(1, 10);
+    Graph grid(side * side);
+    const auto add_edges = [&](graph::VertexId lhs, graph::VertexId rhs) {
+        grid.AddEdge({lhs, rhs, static_cast<double>(weight_distribution(generator))});
+        grid.AddEdge({rhs, lhs, static_cast<double>(weight_distribution(generator))});
+    };
+    for (size_t row = 0; row < side; ++row) {
+        for (size_t column = 0; column < side; ++column) {
+            const graph::VertexId vertex = row * side + column;
+            if (column + 1 < side) {
+                add_edges(vertex, vertex + 1);
+            }
+            if (row + 1 < side) {
+                add_edges(vertex, vertex + side);
+            }
+        }
+    }
+    grid.Freeze();
+    return grid;
+}
+
+struct Totals {
+    size_t settled_vertex_count = 0;
+    double time = 0;
+};
+
+template <typename Router>
+std::vector<double> Run(const Router& router,
+                        const std::vector<std::pair<graph::VertexId, graph::VertexId>>& queries,
+                        Totals& totals) {
+    std::vector<double> weights;
+    weights.reserve(queries.size());
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& [from, to] : queries) {
+        graph::SearchStats stats;
+        const auto route = router.BuildRoute(from, to, stats);
+        totals.settled_vertex_count += stats.settled_vertex_count;
+        weights.push_back(route ? route->weight : -1);
+    }
+    totals.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return weights;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t side = argc > 1 ? std::stoul(argv[1]) : 300;
+    const size_t query_count = argc > 2 ? std::stoul(argv[2]) : 200;
+    const uint32_t seed = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 1;
+
+    std::mt19937 generator(seed);
+    const Graph grid = MakeGrid(side, generator);
+
+    std::uniform_int_distribution<graph::VertexId> vertex_distribution(0, grid.GetVertexCount() - 1);
+    std::vector<std::pair<graph::VertexId, graph::VertexId>> queries(query_count);
+    for (auto& [from, to] : queries) {
+        from = vertex_distribution(generator);
+        to = vertex_distribution(generator);
+    }
+
+    const graph::DijkstraRouter<double> dijkstra(grid);
+    const graph::BidirectionalDijkstraRouter<double> bidirectional(grid);
+    Totals dijkstra_totals;
+    Totals bidirectional_totals;
+    const bool is_equal = Run(dijkstra, queries, dijkstra_totals)
+            == Run(bidirectional, queries, bidirectional_totals);
+
+    const auto print = [query_count](std::string_view name, const Totals& totals) {
+        std::cout << name << ": "sv
+                  << static_cast<double>(totals.settled_vertex_count) / static_cast<double>(query_count)
+                  << " settled vertices per query, "sv
+                  << totals.time << " s\n"sv;
+    };
+    std::cout << side << 'x' << side << " grid, "sv << query_count << " queries, seed "sv << seed << '\n';
+    print("dijkstra"sv, dijkstra_totals);
+    print("bidirectional"sv, bidirectional_totals);
+    std::cout << "settled ratio "sv
+              << static_cast<double>(bidirectional_totals.settled_vertex_count)
+                 / static_cast<double>(dijkstra_totals.settled_vertex_count)
+              << (is_equal ? ", route weights match\n"sv : ", ROUTE WEIGHTS DIFFER\n"sv);
+    return is_equal ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+#include "graph.h"
+#include "min_plus_kernel.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Сравнивает вычисление таблицы кратчайших путей алгоритмом Флойда-Уоршелла
+// прежним циклом по ячейкам std::optional и ядром RelaxRowMinPlus
+// (скалярным и AVX2) по плотным строкам. Граф строится так же, как граф
+// маршрутизатора, по случайной транспортной сети: у остановки есть вершины
+// ожидания и посадки, автобусы задают линии. Выводит время каждого варианта
+// и проверяет, что итоговые веса и последние рёбра совпадают побитово.
+// Запуск: min_plus_kernel_benchmark [число остановок] [число автобусов] [зерно]
+
+using namespace std::string_view_literals;
+
+namespace {
+
+using Graph = graph::DirectedWeightedGraph<double>;
+
+constexpr double BUS_WAIT_TIME = 6.0;
+// Метров в минуту при скорости 40 км/ч
+constexpr double BUS_VELOCITY = 40.0 * 1000.0 / 60.0;
+
+// Вершина ожидания остановки 2 * s, вершина посадки 2 * s + 1
+Graph MakeTransportGraph(size_t stop_count, size_t bus_count, std::mt19937& generator) {
+    std::uniform_int_distribution<size_t> stop_distribution(0, stop_count - 1);
+    std::uniform_int_distribution<size_t> length_distribution(5, 20);
+    std::uniform_int_distribution<int> distance_distribution(200, 3000);
+    std::bernoulli_distribution is_roundtrip(0.5);
+
+    Graph transport_graph(2 * stop_count);
+    for (size_t stop = 0; stop < stop_count; ++stop) {
+        transport_graph.AddEdge({2 * stop, 2 * stop + 1, BUS_WAIT_TIME});
+    }
+    for (size_t bus = 0; bus < bus_count; ++bus) {
+        std::vector<size_t> stops(length_distribution(generator));
+        for (size_t& stop : stops) {
+            stop = stop_distribution(generator);
+        }
+        if (is_roundtrip(generator)) {
+            stops.push_back(stops.front());
+        } else {
+            stops.insert(stops.end(), stops.rbegin() + 1, stops.rend());
+        }
+
+        std::vector<graph::VertexId> from_go;
+        std::vector<graph::VertexId> to_wait;
+        std::vector<double> prefix_weights;
+        double distance = 0.0;
+        for (size_t i = 0; i < stops.size(); ++i) {
+            if (i > 0) {
+                distance += distance_distribution(generator);
+            }
+            from_go.push_back(2 * stops[i] + 1);
+            to_wait.push_back(2 * stops[i]);
+            prefix_weights.push_back(distance / BUS_VELOCITY);
+        }
+        transport_graph.AddLine(std::move(from_go), std::move(to_wait), std::move(prefix_weights));
+    }
+    transport_graph.Freeze();
+    return transport_graph;
+}
+
+// Прежний формат таблицы: ячейка есть только у достижимых пар
+struct RouteInternalData {
+    double weight;
+    std::optional<graph::EdgeId> prev_edge;
+};
+using OptionalTable = std::vector<std::vector<std::optional<RouteInternalData>>>;
+
+// Плотная таблица: недостижимые ячейки хранят +inf
+struct DenseTable {
+    size_t size = 0;
+    std::vector<double> weights;
+    std::vector<uint32_t> prev_edges;
+};
+
+constexpr double UNREACHABLE = std::numeric_limits<double>::infinity();
+constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+// Таблица кратчайших путей из не более чем одного ребра
+OptionalTable MakeOptionalTable(const Graph& transport_graph) {
+    const size_t vertex_count = transport_graph.GetVertexCount();
+    OptionalTable table(vertex_count, std::vector<std::optional<RouteInternalData>>(vertex_count));
+    for (graph::VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        table[vertex][vertex] = RouteInternalData{0.0, std::nullopt};
+        transport_graph.ForEachIncidentEdge(vertex, [&](graph::EdgeId edge_id, const graph::Edge<double>& edge) {
+            auto& route = table[vertex][edge.to];
+            if (!route || route->weight > edge.weight) {
+                route = RouteInternalData{edge.weight, edge_id};
+            }
+        });
+    }
+    return table;
+}
+
+DenseTable MakeDenseTable(const OptionalTable& source) {
+    const size_t size = source.size();
+    DenseTable table{size, std::vector<double>(size * size, UNREACHABLE),
+                     std::vector<uint32_t>(size * size, NO_EDGE)};
+    for (size_t from = 0; from < size; ++from) {
+        for (size_t to = 0; to < size; ++to) {
+            if (const auto& route = source[from][to]) {
+                table.weights[from * size + to] = route->weight;
+                if (route->prev_edge) {
+                    table.prev_edges[from * size + to] = static_cast<uint32_t>(*route->prev_edge);
+                }
+            }
+        }
+    }
+    return table;
+}
+
+double GetSeconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Прежний цикл RelaxRoutesInternalDataThroughVertex с проверкой наличия каждой ячейки
+double RunOptional(OptionalTable& table) {
+    const size_t size = table.size();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t through = 0; through < size; ++through) {
+        for (size_t from = 0; from < size; ++from) {
+            const auto& route_from = table[from][through];
+            if (!route_from) {
+                continue;
+            }
+            for (size_t to = 0; to < size; ++to) {
+                const auto& route_to = table[through][to];
+                if (!route_to) {
+                    continue;
+                }
+                auto& route_relaxing = table[from][to];
+                const double candidate_weight = route_from->weight + route_to->weight;
+                if (!route_relaxing || candidate_weight < route_relaxing->weight) {
+                    route_relaxing = RouteInternalData{candidate_weight,
+                                                       route_to->prev_edge ? route_to->prev_edge
+                                                                           : route_from->prev_edge};
+                }
+            }
+        }
+    }
+    return GetSeconds(start);
+}
+
+using RelaxRowFunction = void (*)(double, const double*, const uint32_t*,
+                                  double*, uint32_t*, size_t);
+
+// Тот же порядок обхода, строка релаксируется ядром целиком
+double RunDense(RelaxRowFunction relax_row, DenseTable& table) {
+    const size_t size = table.size;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t through = 0; through < size; ++through) {
+        const double* weights_through = table.weights.data() + through * size;
+        const uint32_t* prev_edges_through = table.prev_edges.data() + through * size;
+        for (size_t from = 0; from < size; ++from) {
+            const double weight_from = table.weights[from * size + through];
+            if (weight_from == UNREACHABLE) {
+                continue;
+            }
+            relax_row(weight_from, weights_through, prev_edges_through,
+                      table.weights.data() + from * size, table.prev_edges.data() + from * size, size);
+        }
+    }
+    return GetSeconds(start);
+}
+
+bool IsEqual(const OptionalTable& expected, const DenseTable& table) {
+    const DenseTable expected_dense = MakeDenseTable(expected);
+    return std::memcmp(expected_dense.weights.data(), table.weights.data(),
+                       table.weights.size() * sizeof(double)) == 0
+            && expected_dense.prev_edges == table.prev_edges;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t stop_count = argc > 1 ? std::stoul(argv[1]) : 400;
+    const size_t bus_count = argc > 2 ? std::stoul(argv[2]) : 100;
+    const uint32_t seed = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 1;
+
+    std::mt19937 generator(seed);
+    const Graph transport_graph = MakeTransportGraph(stop_count, bus_count, generator);
+    OptionalTable optional_table = MakeOptionalTable(transport_graph);
+    const DenseTable dense_source = MakeDenseTable(optional_table);
+
+    std::cout << stop_count << " stops, "sv << bus_count << " buses, seed "sv << seed
+              << ", "sv << transport_graph.GetVertexCount() << " vertices\n"sv;
+
+    const double optional_time = RunOptional(optional_table);
+    std::cout << "optional loop: "sv << optional_time << " s\n"sv;
+
+    bool is_equal = true;
+    const auto run_kernel = [&](std::string_view name, RelaxRowFunction relax_row) {
+        DenseTable table = dense_source;
+        const double time = RunDense(relax_row, table);
+        const bool is_kernel_equal = IsEqual(optional_table, table);
+        is_equal = is_equal && is_kernel_equal;
+        std::cout << name << ": "sv << time << " s, speedup "sv << optional_time / time
+                  << (is_kernel_equal ? ", results match\n"sv : ", RESULTS DIFFER\n"sv);
+    };
+
+    run_kernel("scalar kernel"sv, graph::detail::RelaxRowScalar);
+#ifdef MIN_PLUS_KERNEL_AVX2
+    if (graph::detail::IsAvx2Supported()) {
+        run_kernel("avx2 kernel"sv, graph::detail::RelaxRowAvx2);
+    } else {
+        std::cout << "AVX2 is not supported by the processor\n"sv;
+    }
+#else
+    std::cout << "AVX2 kernel is not built for this platform\n"sv;
+#endif
+    return is_equal ? 0 : 1;
+}
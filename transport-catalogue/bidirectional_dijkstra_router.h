@@ -0,0 +1,160 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Двунаправленный поиск Дейкстры между парой вершин: прямой поиск идёт
+// от начала, обратный от цели по входящим рёбрам графа. Поиск останавливается,
+// когда сумма минимумов очередей не меньше лучшего найденного пути.
+template <typename Weight>
+class BidirectionalDijkstraRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    explicit BidirectionalDijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, SearchStats& stats) const;
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    // Состояние поиска в одном направлении. Для обратного поиска
+    // edges хранит рёбра, ведущие из вершины к цели
+    struct SearchState {
+        std::vector<std::optional<Weight>> weights;
+        std::vector<std::optional<EdgeId>> edges;
+        Queue queue;
+    };
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+};
+
+template <typename Weight>
+BidirectionalDijkstraRouter<Weight>::BidirectionalDijkstraRouter(const Graph& graph)
+    : graph_(graph)
+{
+    if (graph.HasNegativeWeights()) {
+        throw std::domain_error("Edges' weights should be non-negative");
+    }
+}
+
+template <typename Weight>
+std::optional<typename BidirectionalDijkstraRouter<Weight>::RouteInfo>
+BidirectionalDijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to) const
+{
+    SearchStats stats;
+    return BuildRoute(from, to, stats);
+}
+
+template <typename Weight>
+std::optional<typename BidirectionalDijkstraRouter<Weight>::RouteInfo>
+BidirectionalDijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to, SearchStats& stats) const
+{
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    SearchState forward{std::vector<std::optional<Weight>>(vertex_count),
+                        std::vector<std::optional<EdgeId>>(vertex_count), {}};
+    SearchState backward{std::vector<std::optional<Weight>>(vertex_count),
+                         std::vector<std::optional<EdgeId>>(vertex_count), {}};
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+    const auto update_best = [&](VertexId vertex) {
+        if (!forward.weights[vertex] || !backward.weights[vertex]) {
+            return;
+        }
+        const Weight weight = *forward.weights[vertex] + *backward.weights[vertex];
+        if (!best_weight || weight < *best_weight) {
+            best_weight = weight;
+            meeting_vertex = vertex;
+        }
+    };
+
+    forward.weights[from] = ZERO_WEIGHT;
+    forward.queue.emplace(ZERO_WEIGHT, from);
+    backward.weights[to] = ZERO_WEIGHT;
+    backward.queue.emplace(ZERO_WEIGHT, to);
+    update_best(from);
+    stats.settled_vertex_count = 0;
+
+    while (!forward.queue.empty() && !backward.queue.empty()) {
+        if (best_weight && forward.queue.top().first + backward.queue.top().first >= *best_weight) {
+            break;
+        }
+
+        // Продвигается направление с меньшим минимумом в очереди
+        const bool is_forward = forward.queue.top().first <= backward.queue.top().first;
+        SearchState& state = is_forward ? forward : backward;
+
+        const Weight weight = state.queue.top().first;
+        const VertexId vertex = state.queue.top().second;
+        state.queue.pop();
+        if (weight != *state.weights[vertex]) {
+            continue;
+        }
+        ++stats.settled_vertex_count;
+
+        const auto relax = [&](EdgeId edge_id, VertexId next, Weight edge_weight) {
+            const Weight candidate_weight = weight + edge_weight;
+            auto& weight_next = state.weights[next];
+            if (!weight_next || candidate_weight < *weight_next) {
+                weight_next = candidate_weight;
+                state.edges[next] = edge_id;
+                state.queue.emplace(candidate_weight, next);
+                update_best(next);
+            }
+        };
+
+        if (is_forward) {
+            graph_.ForEachIncidentEdge(vertex, [&relax](EdgeId edge_id, const Edge<Weight>& edge) {
+                relax(edge_id, edge.to, edge.weight);
+            });
+        } else {
+            graph_.ForEachIncomingEdge(vertex, [&relax](EdgeId edge_id, const Edge<Weight>& edge) {
+                relax(edge_id, edge.from, edge.weight);
+            });
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = forward.edges[meeting_vertex];
+         edge_id;
+         edge_id = forward.edges[graph_.GetEdge(*edge_id).from])
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+    for (std::optional<EdgeId> edge_id = backward.edges[meeting_vertex];
+         edge_id;
+         edge_id = backward.edges[graph_.GetEdge(*edge_id).to])
+    {
+        edges.push_back(*edge_id);
+    }
+
+    return RouteInfo{*best_weight, std::move(edges)};
+}
+
+}  // namespace graph
@@ -0,0 +1,576 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Иерархия сжатий (Contraction Hierarchies). Вершины по очереди удаляются
+// из графа, а пути через удалённую вершину заменяются ярлыками (shortcut),
+// если более короткого обхода нет. Запрос — двунаправленный поиск только
+// вверх по порядку удаления. Рёбра иерархии нумеруются так: id меньше
+// границы id рёбер графа совпадают с исходными рёбрами, остальные — ярлыки,
+// каждый из которых помнит два ребра иерархии, которые он заменяет.
+template <typename Weight>
+class ContractionHierarchyRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    explicit ContractionHierarchyRouter(const Graph& graph);
+    ContractionHierarchyRouter(const Graph& graph, const proto::graph::Router& proto_router);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    // Веса по корзинам: поиск вверх от каждой цели раскладывает веса по
+    // достигнутым вершинам, поиск вверх от каждого начала просматривает их
+    std::vector<std::vector<std::optional<Weight>>>
+    BuildWeightMatrix(const std::vector<VertexId>& from, const std::vector<VertexId>& to) const override;
+    size_t GetIndexSize() const override {
+        return ranks_.size() * sizeof(uint32_t)
+               + shortcuts_.size() * sizeof(Shortcut)
+               + (up_offsets_.size() + down_offsets_.size()) * sizeof(size_t)
+               + (up_edges_.size() + down_edges_.size()) * sizeof(EdgeId);
+    }
+
+    bool Serialise(proto::graph::Router& proto_router) const override;
+    bool Deserialise(const proto::graph::Router& proto_router);
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    struct Shortcut {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId first;
+        EdgeId second;
+    };
+
+    // Состояние поиска в одном направлении при построении маршрута
+    struct SearchState {
+        std::vector<std::optional<Weight>> weights;
+        std::vector<std::optional<EdgeId>> edges;
+        Queue queue;
+    };
+
+    // Поиск свидетеля — обходного пути, делающего ярлык ненужным
+    class WitnessSearch {
+    public:
+        explicit WitnessSearch(size_t vertex_count)
+            : weights_(vertex_count)
+        {}
+
+        // Веса путей из from, не проходящих через ignored и не длиннее limit
+        template <typename OutgoingEdges>
+        void Run(VertexId from, VertexId ignored, Weight limit, OutgoingEdges&& outgoing_edges);
+
+        std::optional<Weight> GetWeight(VertexId vertex) const {
+            return weights_[vertex];
+        }
+
+    private:
+        // Ограничение на число просмотренных вершин: если свидетель
+        // не найден вовремя, ярлык просто добавляется
+        static constexpr size_t SETTLE_LIMIT = 100;
+
+        std::vector<std::optional<Weight>> weights_;
+        std::vector<VertexId> touched_;
+    };
+
+    void Contract();
+    void BuildSearchGraphs();
+
+    // Полный поиск вверх по иерархии. weights — рабочий массив, пустой
+    // до и после вызова. Возвращает достигнутые вершины с весами путей
+    std::vector<std::pair<VertexId, Weight>> SearchUp(VertexId source, bool is_forward,
+                                                      std::vector<std::optional<Weight>>& weights) const;
+
+    VertexId GetFrom(EdgeId edge_id) const;
+    VertexId GetTo(EdgeId edge_id) const;
+    Weight GetWeight(EdgeId edge_id) const;
+    void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    std::vector<uint32_t> ranks_;
+    std::vector<Shortcut> shortcuts_;
+    // Рёбра к вершинам старшего ранга: up — исходящие, down — входящие.
+    // Хранятся в форме CSR так же, как рёбра графа
+    std::vector<size_t> up_offsets_;
+    std::vector<EdgeId> up_edges_;
+    std::vector<size_t> down_offsets_;
+    std::vector<EdgeId> down_edges_;
+};
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph)
+    : graph_(graph)
+{
+    if (graph.HasNegativeWeights()) {
+        throw std::domain_error("Edges' weights should be non-negative");
+    }
+    Contract();
+    BuildSearchGraphs();
+}
+
+template <typename Weight>
+template <typename OutgoingEdges>
+void ContractionHierarchyRouter<Weight>::WitnessSearch::Run(VertexId from, VertexId ignored, Weight limit,
+                                                            OutgoingEdges&& outgoing_edges)
+{
+    for (const VertexId vertex : touched_) {
+        weights_[vertex].reset();
+    }
+    touched_.clear();
+
+    Queue queue;
+    weights_[from] = ZERO_WEIGHT;
+    touched_.push_back(from);
+    queue.emplace(ZERO_WEIGHT, from);
+
+    size_t settled_count = 0;
+    while (!queue.empty() && settled_count < SETTLE_LIMIT) {
+        const Weight weight = queue.top().first;
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+        if (weight != *weights_[vertex]) {
+            continue;
+        }
+        if (weight > limit) {
+            break;
+        }
+        ++settled_count;
+        outgoing_edges(vertex, [&](VertexId next, Weight edge_weight) {
+            if (next == ignored) {
+                return;
+            }
+            const Weight candidate_weight = weight + edge_weight;
+            auto& weight_next = weights_[next];
+            if (!weight_next) {
+                touched_.push_back(next);
+            } else if (!(candidate_weight < *weight_next)) {
+                return;
+            }
+            weight_next = candidate_weight;
+            queue.emplace(candidate_weight, next);
+        });
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::Contract() {
+    const size_t vertex_count = graph_.GetVertexCount();
+
+    // На время сжатия рёбра иерархии нумеруются подряд: исходные рёбра,
+    // затем ярлыки. hierarchy_ids хранит их id в иерархии. Ярлыки
+    // появляются между вершинами, которые ещё не удалены, поэтому копия
+    // нужна только на время сжатия
+    std::vector<Edge<Weight>> hierarchy_edges;
+    std::vector<EdgeId> hierarchy_ids;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        graph_.ForEachIncidentEdge(vertex, [&](EdgeId edge_id, const Edge<Weight>& edge) {
+            hierarchy_edges.push_back(edge);
+            hierarchy_ids.push_back(edge_id);
+        });
+    }
+    const auto get_from = [&hierarchy_edges](EdgeId edge_id) { return hierarchy_edges[edge_id].from; };
+    const auto get_to = [&hierarchy_edges](EdgeId edge_id) { return hierarchy_edges[edge_id].to; };
+    const auto get_weight = [&hierarchy_edges](EdgeId edge_id) { return hierarchy_edges[edge_id].weight; };
+
+    // Рёбра между ещё не удалёнными вершинами
+    std::vector<std::vector<EdgeId>> outgoing(vertex_count);
+    std::vector<std::vector<EdgeId>> incoming(vertex_count);
+    for (EdgeId edge_id = 0; edge_id < hierarchy_edges.size(); ++edge_id) {
+        const auto& edge = hierarchy_edges[edge_id];
+        if (edge.from == edge.to) {
+            continue;
+        }
+        outgoing[edge.from].push_back(edge_id);
+        incoming[edge.to].push_back(edge_id);
+    }
+
+    std::vector<bool> contracted(vertex_count, false);
+    std::vector<size_t> contracted_neighbours(vertex_count, 0);
+    WitnessSearch witness_search(vertex_count);
+
+    const auto for_each_outgoing = [&](VertexId vertex, const auto& callback) {
+        for (const EdgeId edge_id : outgoing[vertex]) {
+            callback(get_to(edge_id), get_weight(edge_id));
+        }
+    };
+
+    // Перебирает ярлыки, нужные при удалении вершины. Из параллельных
+    // рёбер достаточно самого лёгкого
+    const auto for_each_shortcut = [&](VertexId vertex, const auto& callback) {
+        const auto lightest = [&](const std::vector<EdgeId>& edges, auto get_end) {
+            std::vector<EdgeId> result;
+            for (const EdgeId edge_id : edges) {
+                const auto it = std::find_if(result.begin(), result.end(), [&](EdgeId other) {
+                    return get_end(other) == get_end(edge_id);
+                });
+                if (it == result.end()) {
+                    result.push_back(edge_id);
+                } else if (get_weight(edge_id) < get_weight(*it)) {
+                    *it = edge_id;
+                }
+            }
+            return result;
+        };
+        const std::vector<EdgeId> in_edges = lightest(incoming[vertex], get_from);
+        const std::vector<EdgeId> out_edges = lightest(outgoing[vertex], get_to);
+        if (out_edges.empty()) {
+            return;
+        }
+        Weight max_out_weight = get_weight(out_edges.front());
+        for (const EdgeId out_edge : out_edges) {
+            max_out_weight = std::max(max_out_weight, get_weight(out_edge));
+        }
+
+        for (const EdgeId in_edge : in_edges) {
+            const VertexId from = get_from(in_edge);
+            witness_search.Run(from, vertex, get_weight(in_edge) + max_out_weight, for_each_outgoing);
+            for (const EdgeId out_edge : out_edges) {
+                const VertexId to = get_to(out_edge);
+                if (to == from) {
+                    continue;
+                }
+                const Weight weight = get_weight(in_edge) + get_weight(out_edge);
+                const std::optional<Weight> witness_weight = witness_search.GetWeight(to);
+                if (!witness_weight || weight < *witness_weight) {
+                    callback(Shortcut{from, to, weight, in_edge, out_edge});
+                }
+            }
+        }
+    };
+
+    // Приоритет вершины: разность добавленных и удалённых рёбер
+    // плюс число уже удалённых соседей для равномерности
+    const auto priority = [&](VertexId vertex, size_t shortcut_count) {
+        return static_cast<int64_t>(shortcut_count)
+               - static_cast<int64_t>(incoming[vertex].size() + outgoing[vertex].size())
+               + static_cast<int64_t>(contracted_neighbours[vertex]);
+    };
+    const auto collect_shortcuts = [&](VertexId vertex) {
+        std::vector<Shortcut> shortcuts;
+        for_each_shortcut(vertex, [&shortcuts](const Shortcut& shortcut) {
+            shortcuts.push_back(shortcut);
+        });
+        return shortcuts;
+    };
+
+    using PriorityItem = std::pair<int64_t, VertexId>;
+    std::priority_queue<PriorityItem, std::vector<PriorityItem>, std::greater<PriorityItem>> order;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        order.emplace(priority(vertex, collect_shortcuts(vertex).size()), vertex);
+    }
+
+    ranks_.assign(vertex_count, 0);
+    uint32_t rank = 0;
+    while (!order.empty()) {
+        const VertexId vertex = order.top().second;
+        order.pop();
+        if (contracted[vertex]) {
+            continue;
+        }
+        // Ленивое обновление: приоритет пересчитывается перед удалением
+        const std::vector<Shortcut> new_shortcuts = collect_shortcuts(vertex);
+        const int64_t current_priority = priority(vertex, new_shortcuts.size());
+        if (!order.empty() && current_priority > order.top().first) {
+            order.emplace(current_priority, vertex);
+            continue;
+        }
+
+        contracted[vertex] = true;
+        ranks_[vertex] = rank++;
+
+        const auto detach = [&](std::vector<EdgeId>& edges) {
+            edges.erase(std::remove_if(edges.begin(), edges.end(), [&](EdgeId edge_id) {
+                return get_from(edge_id) == vertex || get_to(edge_id) == vertex;
+            }), edges.end());
+        };
+        for (const EdgeId edge_id : incoming[vertex]) {
+            const VertexId neighbour = get_from(edge_id);
+            detach(outgoing[neighbour]);
+            ++contracted_neighbours[neighbour];
+        }
+        for (const EdgeId edge_id : outgoing[vertex]) {
+            const VertexId neighbour = get_to(edge_id);
+            detach(incoming[neighbour]);
+            ++contracted_neighbours[neighbour];
+        }
+
+        for (const Shortcut& shortcut : new_shortcuts) {
+            const EdgeId edge_id = hierarchy_edges.size();
+            shortcuts_.push_back({shortcut.from, shortcut.to, shortcut.weight,
+                                  hierarchy_ids[shortcut.first], hierarchy_ids[shortcut.second]});
+            hierarchy_edges.push_back({shortcut.from, shortcut.to, shortcut.weight});
+            hierarchy_ids.push_back(graph_.GetEdgeIdBound() + shortcuts_.size() - 1);
+            outgoing[shortcut.from].push_back(edge_id);
+            incoming[shortcut.to].push_back(edge_id);
+        }
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::BuildSearchGraphs() {
+    const size_t vertex_count = graph_.GetVertexCount();
+
+    // Обходит рёбра графа и ярлыки, callback(edge_id, from, to)
+    const auto for_each_edge = [this, vertex_count](const auto& callback) {
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            graph_.ForEachIncidentEdge(vertex, [&callback](EdgeId edge_id, const Edge<Weight>& edge) {
+                callback(edge_id, edge.from, edge.to);
+            });
+        }
+        for (size_t index = 0; index < shortcuts_.size(); ++index) {
+            callback(graph_.GetEdgeIdBound() + index, shortcuts_[index].from, shortcuts_[index].to);
+        }
+    };
+
+    up_offsets_.assign(vertex_count + 1, 0);
+    down_offsets_.assign(vertex_count + 1, 0);
+    for_each_edge([this](EdgeId, VertexId from, VertexId to) {
+        if (ranks_[from] < ranks_[to]) {
+            ++up_offsets_[from + 1];
+        } else if (ranks_[from] > ranks_[to]) {
+            ++down_offsets_[to + 1];
+        }
+    });
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        up_offsets_[vertex + 1] += up_offsets_[vertex];
+        down_offsets_[vertex + 1] += down_offsets_[vertex];
+    }
+
+    up_edges_.resize(up_offsets_.back());
+    down_edges_.resize(down_offsets_.back());
+    std::vector<size_t> up_positions(up_offsets_.begin(), up_offsets_.end() - 1);
+    std::vector<size_t> down_positions(down_offsets_.begin(), down_offsets_.end() - 1);
+    for_each_edge([&](EdgeId edge_id, VertexId from, VertexId to) {
+        if (ranks_[from] < ranks_[to]) {
+            up_edges_[up_positions[from]++] = edge_id;
+        } else if (ranks_[from] > ranks_[to]) {
+            down_edges_[down_positions[to]++] = edge_id;
+        }
+    });
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const
+{
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    SearchState forward{std::vector<std::optional<Weight>>(vertex_count),
+                        std::vector<std::optional<EdgeId>>(vertex_count), {}};
+    SearchState backward{std::vector<std::optional<Weight>>(vertex_count),
+                         std::vector<std::optional<EdgeId>>(vertex_count), {}};
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+    const auto update_best = [&](VertexId vertex) {
+        if (!forward.weights[vertex] || !backward.weights[vertex]) {
+            return;
+        }
+        const Weight weight = *forward.weights[vertex] + *backward.weights[vertex];
+        if (!best_weight || weight < *best_weight) {
+            best_weight = weight;
+            meeting_vertex = vertex;
+        }
+    };
+
+    forward.weights[from] = ZERO_WEIGHT;
+    forward.queue.emplace(ZERO_WEIGHT, from);
+    backward.weights[to] = ZERO_WEIGHT;
+    backward.queue.emplace(ZERO_WEIGHT, to);
+    update_best(from);
+
+    // Поиски вверх не обязаны встретиться в середине, поэтому каждый
+    // идёт, пока минимум его очереди меньше лучшего найденного пути
+    const auto is_active = [&best_weight](const SearchState& state) {
+        return !state.queue.empty() && (!best_weight || state.queue.top().first < *best_weight);
+    };
+
+    while (is_active(forward) || is_active(backward)) {
+        const bool is_forward = is_active(forward)
+                && (!is_active(backward) || forward.queue.top().first <= backward.queue.top().first);
+        SearchState& state = is_forward ? forward : backward;
+
+        const auto [weight, vertex] = state.queue.top();
+        state.queue.pop();
+        if (weight != *state.weights[vertex]) {
+            continue;
+        }
+
+        const auto& offsets = is_forward ? up_offsets_ : down_offsets_;
+        const auto& edges = is_forward ? up_edges_ : down_edges_;
+        for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            const EdgeId edge_id = edges[i];
+            const VertexId next = is_forward ? GetTo(edge_id) : GetFrom(edge_id);
+            const Weight candidate_weight = weight + GetWeight(edge_id);
+            auto& weight_next = state.weights[next];
+            if (!weight_next || candidate_weight < *weight_next) {
+                weight_next = candidate_weight;
+                state.edges[next] = edge_id;
+                state.queue.emplace(candidate_weight, next);
+                update_best(next);
+            }
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> hierarchy_edges;
+    for (std::optional<EdgeId> edge_id = forward.edges[meeting_vertex];
+         edge_id;
+         edge_id = forward.edges[GetFrom(*edge_id)])
+    {
+        hierarchy_edges.push_back(*edge_id);
+    }
+    std::reverse(hierarchy_edges.begin(), hierarchy_edges.end());
+    for (std::optional<EdgeId> edge_id = backward.edges[meeting_vertex];
+         edge_id;
+         edge_id = backward.edges[GetTo(*edge_id)])
+    {
+        hierarchy_edges.push_back(*edge_id);
+    }
+
+    std::vector<EdgeId> edges;
+    for (const EdgeId edge_id : hierarchy_edges) {
+        UnpackEdge(edge_id, edges);
+    }
+
+    return RouteInfo{*best_weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::vector<std::vector<std::optional<Weight>>>
+ContractionHierarchyRouter<Weight>::BuildWeightMatrix(const std::vector<VertexId>& from,
+                                                      const std::vector<VertexId>& to) const
+{
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<std::optional<Weight>> weights(vertex_count);
+
+    // Корзина вершины: номера целей и веса путей от вершины до них
+    std::vector<std::vector<std::pair<size_t, Weight>>> buckets(vertex_count);
+    for (size_t target = 0; target < to.size(); ++target) {
+        for (const auto& [vertex, weight] : SearchUp(to[target], false, weights)) {
+            buckets[vertex].emplace_back(target, weight);
+        }
+    }
+
+    std::vector<std::vector<std::optional<Weight>>> matrix(from.size(),
+                                                           std::vector<std::optional<Weight>>(to.size()));
+    for (size_t origin = 0; origin < from.size(); ++origin) {
+        auto& row = matrix[origin];
+        for (const auto& [vertex, weight] : SearchUp(from[origin], true, weights)) {
+            for (const auto& [target, bucket_weight] : buckets[vertex]) {
+                const Weight total_weight = weight + bucket_weight;
+                if (!row[target] || total_weight < *row[target]) {
+                    row[target] = total_weight;
+                }
+            }
+        }
+    }
+    return matrix;
+}
+
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>>
+ContractionHierarchyRouter<Weight>::SearchUp(VertexId source, bool is_forward,
+                                             std::vector<std::optional<Weight>>& weights) const
+{
+    if (source >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const auto& offsets = is_forward ? up_offsets_ : down_offsets_;
+    const auto& edges = is_forward ? up_edges_ : down_edges_;
+
+    std::vector<std::pair<VertexId, Weight>> settled;
+    Queue queue;
+    weights[source] = ZERO_WEIGHT;
+    queue.emplace(ZERO_WEIGHT, source);
+    while (!queue.empty()) {
+        const Weight weight = queue.top().first;
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+        if (weight != *weights[vertex]) {
+            continue;
+        }
+        settled.emplace_back(vertex, weight);
+        for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            const EdgeId edge_id = edges[i];
+            const VertexId next = is_forward ? GetTo(edge_id) : GetFrom(edge_id);
+            const Weight candidate_weight = weight + GetWeight(edge_id);
+            auto& weight_next = weights[next];
+            if (!weight_next || candidate_weight < *weight_next) {
+                weight_next = candidate_weight;
+                queue.emplace(candidate_weight, next);
+            }
+        }
+    }
+
+    // Все достигнутые вершины окончательно просмотрены
+    for (const auto& item : settled) {
+        weights[item.first].reset();
+    }
+    return settled;
+}
+
+template <typename Weight>
+VertexId ContractionHierarchyRouter<Weight>::GetFrom(EdgeId edge_id) const {
+    if (edge_id < graph_.GetEdgeIdBound()) {
+        return graph_.GetEdge(edge_id).from;
+    }
+    return shortcuts_[edge_id - graph_.GetEdgeIdBound()].from;
+}
+
+template <typename Weight>
+VertexId ContractionHierarchyRouter<Weight>::GetTo(EdgeId edge_id) const {
+    if (edge_id < graph_.GetEdgeIdBound()) {
+        return graph_.GetEdge(edge_id).to;
+    }
+    return shortcuts_[edge_id - graph_.GetEdgeIdBound()].to;
+}
+
+template <typename Weight>
+Weight ContractionHierarchyRouter<Weight>::GetWeight(EdgeId edge_id) const {
+    if (edge_id < graph_.GetEdgeIdBound()) {
+        return graph_.GetEdge(edge_id).weight;
+    }
+    return shortcuts_[edge_id - graph_.GetEdgeIdBound()].weight;
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const {
+    std::vector<EdgeId> stack{edge_id};
+    while (!stack.empty()) {
+        const EdgeId current = stack.back();
+        stack.pop_back();
+        if (current < graph_.GetEdgeIdBound()) {
+            edges.push_back(current);
+            continue;
+        }
+        const Shortcut& shortcut = shortcuts_[current - graph_.GetEdgeIdBound()];
+        stack.push_back(shortcut.second);
+        stack.push_back(shortcut.first);
+    }
+}
+
+}  // namespace graph
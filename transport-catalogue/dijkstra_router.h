@@ -0,0 +1,227 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Поиск кратчайшего пути алгоритмом Дейкстры отдельно для каждого запроса.
+// Не требует предварительных вычислений, память линейна по числу рёбер.
+// Маршруты из одной вершины в несколько целей строятся одним поиском.
+template <typename Weight>
+class DijkstraRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, SearchStats& stats) const;
+    std::vector<std::optional<RouteInfo>>
+    BuildRoutes(VertexId from, const std::vector<VertexId>& to) const override;
+    std::vector<std::optional<Weight>>
+    BuildWeights(VertexId from, const std::vector<VertexId>& to) const override;
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    // Дерево кратчайших путей из одной вершины
+    struct ShortestPathTree {
+        std::vector<std::optional<Weight>> weights;
+        std::vector<std::optional<EdgeId>> prev_edges;
+        size_t settled_vertex_count = 0;
+    };
+
+    // Поиск останавливается, как только все цели достигнуты окончательно
+    ShortestPathTree Search(VertexId from, const std::vector<VertexId>& targets) const;
+    std::optional<RouteInfo> ExtractRoute(const ShortestPathTree& tree, VertexId to) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+{
+    if (graph.HasNegativeWeights()) {
+        throw std::domain_error("Edges' weights should be non-negative");
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+DijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to) const
+{
+    return ExtractRoute(Search(from, {to}), to);
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+DijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to, SearchStats& stats) const
+{
+    const ShortestPathTree tree = Search(from, {to});
+    stats.settled_vertex_count = tree.settled_vertex_count;
+    return ExtractRoute(tree, to);
+}
+
+template <typename Weight>
+std::vector<std::optional<typename DijkstraRouter<Weight>::RouteInfo>>
+DijkstraRouter<Weight>::BuildRoutes(VertexId from, const std::vector<VertexId>& to) const
+{
+    const ShortestPathTree tree = Search(from, to);
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(to.size());
+    for (const VertexId target : to) {
+        routes.push_back(ExtractRoute(tree, target));
+    }
+    return routes;
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>>
+DijkstraRouter<Weight>::BuildWeights(VertexId from, const std::vector<VertexId>& to) const
+{
+    const ShortestPathTree tree = Search(from, to);
+    std::vector<std::optional<Weight>> weights;
+    weights.reserve(to.size());
+    for (const VertexId target : to) {
+        weights.push_back(tree.weights[target]);
+    }
+    return weights;
+}
+
+template <typename Weight>
+typename DijkstraRouter<Weight>::ShortestPathTree
+DijkstraRouter<Weight>::Search(VertexId from, const std::vector<VertexId>& targets) const
+{
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    std::vector<bool> is_target(vertex_count, false);
+    size_t targets_left = 0;
+    for (const VertexId target : targets) {
+        if (target >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        if (!is_target[target]) {
+            is_target[target] = true;
+            ++targets_left;
+        }
+    }
+
+    ShortestPathTree tree{std::vector<std::optional<Weight>>(vertex_count),
+                          std::vector<std::optional<EdgeId>>(vertex_count)};
+    std::vector<bool> settled(vertex_count, false);
+
+    Queue queue;
+    tree.weights[from] = ZERO_WEIGHT;
+    queue.emplace(ZERO_WEIGHT, from);
+
+    while (!queue.empty() && targets_left > 0) {
+        const Weight weight = queue.top().first;
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+        if (settled[vertex]) {
+            continue;
+        }
+        settled[vertex] = true;
+        ++tree.settled_vertex_count;
+        if (is_target[vertex] && --targets_left == 0) {
+            break;
+        }
+        graph_.ForEachIncidentEdge(vertex, [&](EdgeId edge_id, const Edge<Weight>& edge) {
+            const Weight candidate_weight = weight + edge.weight;
+            auto& weight_to = tree.weights[edge.to];
+            if (!weight_to || candidate_weight < *weight_to) {
+                weight_to = candidate_weight;
+                tree.prev_edges[edge.to] = edge_id;
+                queue.emplace(candidate_weight, edge.to);
+            }
+        });
+    }
+
+    return tree;
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+DijkstraRouter<Weight>::ExtractRoute(const ShortestPathTree& tree, VertexId to) const
+{
+    if (!tree.weights[to]) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = tree.prev_edges[to];
+         edge_id;
+         edge_id = tree.prev_edges[graph_.GetEdge(*edge_id).from])
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{*tree.weights[to], std::move(edges)};
+}
+
+// Вершины, до которых из from есть путь весом не больше max_weight,
+// с весами путей по возрастанию. Вершины за пределом не раскрываются,
+// поэтому поиск просматривает только окрестность from
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>>
+FindReachable(const DirectedWeightedGraph<Weight>& graph, VertexId from, Weight max_weight)
+{
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    if (from >= graph.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    std::vector<std::pair<VertexId, Weight>> reachable;
+    if (max_weight < Weight{}) {
+        return reachable;
+    }
+
+    std::vector<std::optional<Weight>> weights(graph.GetVertexCount());
+    Queue queue;
+    weights[from] = Weight{};
+    queue.emplace(Weight{}, from);
+    while (!queue.empty()) {
+        const Weight weight = queue.top().first;
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+        if (weight != *weights[vertex]) {
+            continue;
+        }
+        reachable.emplace_back(vertex, weight);
+        graph.ForEachIncidentEdge(vertex, [&](EdgeId, const Edge<Weight>& edge) {
+            const Weight candidate_weight = weight + edge.weight;
+            if (max_weight < candidate_weight) {
+                return;
+            }
+            auto& weight_to = weights[edge.to];
+            if (!weight_to || candidate_weight < *weight_to) {
+                weight_to = candidate_weight;
+                queue.emplace(candidate_weight, edge.to);
+            }
+        });
+    }
+    return reachable;
+}
+
+}  // namespace graph
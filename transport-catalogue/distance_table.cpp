@@ -0,0 +1,77 @@
+#include "distance_table.h"
+
+#include <utility>
+
+void DistanceTable::Reserve(size_t count) {
+    // Каждое явное расстояние может занять и ячейку обратного направления
+    const size_t capacity {(2 * count * 100 + MAX_LOAD - 1) / MAX_LOAD};
+    if (capacity > m_slots.size()) {
+        Rehash(capacity);
+    }
+}
+
+void DistanceTable::Set(StopId from, StopId to, int distance) {
+    Insert(from, to, distance, true);
+    Insert(to, from, distance, false);
+}
+
+std::optional<int> DistanceTable::Find(StopId from, StopId to) const {
+    if (m_slots.empty()) {
+        return std::nullopt;
+    }
+    const Slot& slot {m_slots[FindSlot(from, to)]};
+    if (slot.from == NO_STOP) {
+        return std::nullopt;
+    }
+    return slot.distance;
+}
+
+size_t DistanceTable::FindSlot(StopId from, StopId to) const {
+    // Перемешивание битов упакованного ключа (финализатор splitmix64)
+    uint64_t hash {(static_cast<uint64_t>(from) << 32) | to};
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+
+    // Старшие биты хеша отображаются на размер таблицы умножением,
+    // поэтому размер не обязан быть степенью двойки
+    size_t index {static_cast<size_t>(((hash >> 32) * m_slots.size()) >> 32)};
+    while (m_slots[index].from != NO_STOP
+           && (m_slots[index].from != from || m_slots[index].to != to)) {
+        if (++index == m_slots.size()) {
+            index = 0;
+        }
+    }
+    return index;
+}
+
+void DistanceTable::Insert(StopId from, StopId to, int distance, bool is_explicit) {
+    if ((m_size + 1) * 100 > m_slots.size() * MAX_LOAD) {
+        Rehash(m_slots.empty() ? 16 : 2 * m_slots.size());
+    }
+    const size_t index {FindSlot(from, to)};
+    Slot& slot {m_slots[index]};
+    if (slot.from == NO_STOP) {
+        slot = {from, to, distance};
+        m_is_explicit[index] = is_explicit;
+        ++m_size;
+    } else if (is_explicit || !m_is_explicit[index]) {
+        // Явно заданное расстояние не заменяется обратным
+        slot.distance = distance;
+        m_is_explicit[index] = m_is_explicit[index] || is_explicit;
+    }
+}
+
+void DistanceTable::Rehash(size_t capacity) {
+    std::vector<Slot> slots(capacity);
+    std::vector<bool> is_explicit(capacity, false);
+    std::swap(m_slots, slots);
+    std::swap(m_is_explicit, is_explicit);
+    for (size_t index {0}; index < slots.size(); ++index) {
+        if (slots[index].from != NO_STOP) {
+            const size_t new_index {FindSlot(slots[index].from, slots[index].to)};
+            m_slots[new_index] = slots[index];
+            m_is_explicit[new_index] = is_explicit[index];
+        }
+    }
+}
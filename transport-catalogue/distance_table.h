@@ -0,0 +1,57 @@
+#pragma once
+
+#include "domain.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+// Дорожные расстояния между остановками в плоской хеш-таблице с открытой
+// адресацией. Ключ — пара номеров остановок, хешируемая как одно 64-битное число.
+// Обратное направление заполняется при вставке, если оно не задано явно,
+// поэтому поиск расстояния делает одну пробу таблицы
+class DistanceTable
+{
+public:
+    // Подготавливает таблицу к count явно заданным расстояниям
+    void Reserve(size_t count);
+
+    void Set(StopId from, StopId to, int distance);
+    std::optional<int> Find(StopId from, StopId to) const;
+
+    // Вызывает callback(from, to, distance) для явно заданных расстояний
+    template <typename Callback>
+    void ForEachExplicit(Callback&& callback) const;
+
+private:
+    struct Slot {
+        StopId from {NO_STOP};
+        StopId to {NO_STOP};
+        int distance {0};
+    };
+
+    static constexpr StopId NO_STOP {std::numeric_limits<StopId>::max()};
+    // Наибольшая доля занятых ячеек, в процентах
+    static constexpr size_t MAX_LOAD {75};
+
+    size_t FindSlot(StopId from, StopId to) const;
+    void Insert(StopId from, StopId to, int distance, bool is_explicit);
+    void Rehash(size_t capacity);
+
+    std::vector<Slot> m_slots;
+    // Признак явно заданного расстояния для каждой ячейки
+    std::vector<bool> m_is_explicit;
+    size_t m_size {0};
+};
+
+template <typename Callback>
+void DistanceTable::ForEachExplicit(Callback&& callback) const {
+    for (size_t index {0}; index < m_slots.size(); ++index) {
+        const Slot& slot {m_slots[index]};
+        if (slot.from != NO_STOP && m_is_explicit[index]) {
+            callback(slot.from, slot.to, slot.distance);
+        }
+    }
+}
@@ -1,6 +1,8 @@
 #include "domain.h"
 #include "json_builder.h"
 
+#include <stdexcept>
+
 using namespace std::string_literals;
 
 StopData::StopData(const json::Node& node)
@@ -73,12 +75,6 @@ bool Bus::operator==(const Bus& other) const {
     return name == other.name;
 }
 
-size_t PairStopsHasher::operator() (const PairStops stops) const {
-    size_t h_first = hasher(stops.first);
-    size_t h_second = hasher(stops.second);
-    return h_first + h_second * 37;
-}
-
 RenderSettings::RenderSettings(const json::Node& node)
 {
     FromJSON(node);
@@ -137,6 +133,49 @@ RoutingSettings::RoutingSettings(const json::Node& node) {
     const auto& json {node.AsDict()};
     bus_velocity = json.at("bus_velocity"s).AsDouble();
     bus_wait_time = json.at("bus_wait_time"s).AsInt();
+
+    if (json.count("thread_count"s) > 0) {
+        const int count {json.at("thread_count"s).AsInt()};
+        if (count < 1) {
+            throw std::invalid_argument("Invalid Thread Count");
+        }
+        thread_count = static_cast<size_t>(count);
+    }
+
+    if (json.count("cache_capacity"s) > 0) {
+        const int capacity {json.at("cache_capacity"s).AsInt()};
+        if (capacity < 0) {
+            throw std::invalid_argument("Invalid Cache Capacity");
+        }
+        cache_capacity = static_cast<size_t>(capacity);
+    }
+
+    if (json.count("router_type"s) == 0) return;
+    const std::string& type {json.at("router_type"s).AsString()};
+    if (type == "all_pairs"s) {
+        router_type = RouterType::AllPairs;
+    } else if (type == "dijkstra"s) {
+        router_type = RouterType::Dijkstra;
+    } else if (type == "raptor"s) {
+        router_type = RouterType::Raptor;
+    } else if (type == "astar"s) {
+        router_type = RouterType::AStar;
+    } else if (type == "bidirectional"s) {
+        router_type = RouterType::Bidirectional;
+    } else if (type == "contraction_hierarchy"s) {
+        router_type = RouterType::ContractionHierarchy;
+    } else if (type == "hub_labels"s) {
+        router_type = RouterType::HubLabels;
+    } else {
+        throw std::invalid_argument("Invalid Router Type");
+    }
+}
+
+double RoutingSettings::GetRideTime(double distance) const {
+    constexpr int meters_in_kilometer {1000};
+    constexpr int minutes_in_hour {60};
+    return (minutes_in_hour * distance) /
+           (meters_in_kilometer * bus_velocity);
 }
 
 json::Node ErrorInfo::ToJSON(int request_id) const {
@@ -167,8 +206,8 @@ json::Node StopInfo::ToJSON(int request_id) const {
             .Key("buses"s).Value([this]()
                 {
                     json::Array value;
-                    for (const auto bus : buses) {
-                        value.emplace_back(std::string(bus));
+                    for (const BusId bus_id : bus_ids) {
+                        value.emplace_back((*buses)[bus_id].name);
                     }
                     return value;
                 }())
@@ -218,3 +257,56 @@ json::Node RouteInfo::ToJSON(int request_id) const {
         .Build();
 }
 
+json::Node RouteMatrixInfo::ToJSON(int request_id) const {
+    return json::Builder{}
+        .StartDict()
+            .Key("request_id"s).Value(request_id)
+            .Key("total_times"s).Value([this]()
+                {
+                    json::Array value;
+                    value.reserve(total_times.size());
+                    for (const auto& row : total_times) {
+                        json::Array times;
+                        times.reserve(row.size());
+                        for (const auto& time : row) {
+                            if (time) {
+                                times.emplace_back(*time);
+                            } else {
+                                times.emplace_back(nullptr);
+                            }
+                        }
+                        value.emplace_back(std::move(times));
+                    }
+                    return value;
+                }())
+        .EndDict()
+        .Build();
+}
+
+json::Node ReachableInfo::ToJSON(int request_id) const {
+    return json::Builder{}
+        .StartDict()
+            .Key("request_id"s).Value(request_id)
+            .Key("stops"s).Value([this]()
+                {
+                    json::Array value;
+                    value.reserve(stops.size());
+                    for (const auto& stop : stops) {
+                        value.emplace_back(json::Builder{}
+                            .StartDict()
+                                .Key("stop_name"s).Value(std::string(stop.name))
+                                .Key("time"s).Value(stop.time)
+                            .EndDict()
+                            .Build());
+                    }
+                    return value;
+                }())
+        .EndDict()
+        .Build();
+}
+
+json::Node ToJSON(const Info& info, int request_id) {
+    return std::visit([request_id](const auto& value) {
+        return value.ToJSON(request_id);
+    }, info);
+}
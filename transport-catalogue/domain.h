@@ -2,11 +2,15 @@
 
 #include "json.h"
 #include "geo.h"
+#include "ranges.h"
 #include "svg.h"
 
-#include <set>
+#include <cstdint>
+#include <deque>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <variant>
 #include <vector>
 
 struct StopData
@@ -25,6 +29,10 @@ struct BusData
     bool is_roundtrip {false};
 };
 
+// Номера остановок и автобусов в каталоге, выдаются подряд при добавлении
+using StopId = uint32_t;
+using BusId = uint32_t;
+
 class Stop
 {
 public:
@@ -33,19 +41,12 @@ public:
 
     std::string name;
     geo::Coordinates coord;
+    StopId id {0};
 
     bool operator==(const Stop& other) const;
 };
 
 using StopPtrConst = const Stop*;
-using PairStops = std::pair<std::string_view, std::string_view>;
-
-struct PairStopsHasher {
-    size_t operator() (const PairStops stops) const;
-
-private:
-    std::hash<std::string_view> hasher;
-};
 
 class Bus {
 public:
@@ -58,6 +59,7 @@ public:
     size_t num_unique;
     double geo_length {0.0};
     int route_length;
+    BusId id {0};
 
     bool operator==(const Bus& other) const;
 };
@@ -87,11 +89,28 @@ struct RenderSettings
     std::vector<svg::Color> color_palette {};
 };
 
+enum class RouterType {
+    AllPairs,
+    Dijkstra,
+    Raptor,
+    AStar,
+    Bidirectional,
+    ContractionHierarchy,
+    HubLabels
+};
+
 struct RoutingSettings
 {
     RoutingSettings(const json::Node& node);
     int bus_wait_time {1};
     double bus_velocity {1.0};
+    RouterType router_type {RouterType::AllPairs};
+    size_t thread_count {1};
+    // Число маршрутов в кэше, 0 отключает кэш
+    size_t cache_capacity {0};
+
+    // Время поездки в минутах по дорожному расстоянию в метрах
+    double GetRideTime(double distance) const;
 };
 
 struct SerializationSettings
@@ -102,16 +121,14 @@ struct SerializationSettings
     std::string file_name;
 };
 
-struct Info {
-    virtual ~Info() {};
-    virtual json::Node ToJSON(int request_id) const = 0;
-};
+// Результаты запросов хранятся по значению и ссылаются на данные каталога,
+// поэтому ответ на запрос Bus или Stop не выделяет память в куче
 
-struct ErrorInfo : public Info {
-    json::Node ToJSON(int request_id) const override;
+struct ErrorInfo {
+    json::Node ToJSON(int request_id) const;
 };
 
-struct BusInfo : public Info {
+struct BusInfo {
     BusInfo(const std::string_view a_name,
             size_t a_num_stops,
             size_t a_num_unique,
@@ -123,40 +140,42 @@ struct BusInfo : public Info {
           geo_length {a_geo_length},
           route_length {a_route_length}
     {}
-    const std::string_view name;
+    std::string_view name;
     size_t num_stops {0};
     size_t num_unique {0};
     double geo_length {0.0};
     int route_length {0};
-    json::Node ToJSON(int request_id) const override;
+    json::Node ToJSON(int request_id) const;
 };
 
-struct StopInfo : public Info {
-    StopInfo(std::string_view a_name, const std::set<std::string_view>& a_buses)
+struct StopInfo {
+    // Номера автобусов остановки, упорядоченные по названию автобуса
+    using BusIds = ranges::Range<const BusId*>;
+
+    StopInfo(std::string_view a_name, const std::deque<Bus>& a_buses, BusIds a_bus_ids)
         : name {a_name},
-          buses {a_buses}
+          buses {&a_buses},
+          bus_ids {a_bus_ids}
     {}
-    StopInfo(std::string_view a_name)
-        : name {a_name}
-    {}
-    const std::string_view name;
-    const std::set<std::string_view> buses;
-    json::Node ToJSON(int request_id) const override;
+    std::string_view name;
+    const std::deque<Bus>* buses;
+    BusIds bus_ids;
+    json::Node ToJSON(int request_id) const;
 };
 
-struct MapInfo : public Info {
+struct MapInfo {
     MapInfo(std::string a_map)
         : map {std::move(a_map)}
     {}
 
     std::string map;
-    json::Node ToJSON(int request_id) const override;
+    json::Node ToJSON(int request_id) const;
 };
 
 
-struct RouteInfo : public Info {
+struct RouteInfo {
     struct RouteItem {
-        const std::string_view name;
+        std::string_view name;
         bool is_wait {false};
         double time {0.0};
         size_t span_count {0};
@@ -170,5 +189,42 @@ struct RouteInfo : public Info {
 
     double total_time;
     std::vector<RouteItem> items;
-    json::Node ToJSON(int request_id) const override;
+    json::Node ToJSON(int request_id) const;
+};
+
+struct RouteMatrixInfo {
+    // Время в пути по строкам отправления и столбцам назначения,
+    // пустое значение означает, что маршрута нет
+    using TotalTimes = std::vector<std::vector<std::optional<double>>>;
+
+    RouteMatrixInfo(TotalTimes&& a_total_times)
+        : total_times {std::move(a_total_times)}
+    {}
+
+    TotalTimes total_times;
+    json::Node ToJSON(int request_id) const;
 };
+
+struct ReachableInfo {
+    struct Item {
+        std::string_view name;
+        double time {0.0};
+    };
+
+    ReachableInfo(std::vector<Item>&& a_stops)
+        : stops {std::move(a_stops)}
+    {}
+
+    std::vector<Item> stops;
+    json::Node ToJSON(int request_id) const;
+};
+
+using Info = std::variant<ErrorInfo,
+                          BusInfo,
+                          StopInfo,
+                          MapInfo,
+                          RouteInfo,
+                          RouteMatrixInfo,
+                          ReachableInfo>;
+
+json::Node ToJSON(const Info& info, int request_id);
@@ -2,9 +2,11 @@
 
 #include <graph.pb.h>
 
-#include "ranges.h"
-
+#include <algorithm>
 #include <cstdlib>
+#include <optional>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace graph {
@@ -19,21 +21,50 @@ struct Edge {
     Weight weight;
 };
 
+// Неявное ребро линии: из позиции from_position в позицию to_position
+struct LineEdge {
+    size_t line;
+    size_t from_position;
+    size_t to_position;
+};
+
+// После Freeze рёбра хранятся в форме CSR. Линия задаёт неявные рёбра
+// из from[i] в to[j] для всех i < j с весом prefix[j] - prefix[i]
 template <typename Weight>
 class DirectedWeightedGraph {
-private:
-    using IncidenceList = std::vector<EdgeId>;
-    using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
-
 public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
     EdgeId AddEdge(const Edge<Weight>& edge);
+    // Возвращает номер линии
+    size_t AddLine(std::vector<VertexId> from_vertices,
+                   std::vector<VertexId> to_vertices,
+                   std::vector<Weight> prefix_weights);
+
+    // Возвращает новые id явных рёбер, индексированные их прежними id
+    std::vector<EdgeId> Freeze();
+    bool IsFrozen() const;
+    // Заменяет веса, не меняя топологию: edge_weights индексированы id
+    // явных рёбер, prefix_weights — позициями всех линий подряд
+    void Reweight(const std::vector<Weight>& edge_weights,
+                  std::vector<Weight> prefix_weights);
 
     size_t GetVertexCount() const;
-    size_t GetEdgeCount() const;
-    const Edge<Weight>& GetEdge(EdgeId edge_id) const;
-    IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+    // Все id рёбер меньше этой границы, но не каждый id меньше неё занят
+    EdgeId GetEdgeIdBound() const;
+    bool HasEdge(EdgeId edge_id) const;
+    bool HasNegativeWeights() const;
+    Edge<Weight> GetEdge(EdgeId edge_id) const;
+    // Позиции линии для неявного ребра, либо nullopt для явного
+    std::optional<LineEdge> GetLineEdge(EdgeId edge_id) const;
+    // Вызывает callback(edge_id, edge) для исходящих рёбер вершины.
+    // Неявные рёбра получаются здесь без поиска их позиций по id
+    template <typename Callback>
+    void ForEachIncidentEdge(VertexId vertex, Callback&& callback) const;
+    // То же для входящих рёбер: неявные рёбра в позицию j линии
+    // выходят из всех её предыдущих позиций
+    template <typename Callback>
+    void ForEachIncomingEdge(VertexId vertex, Callback&& callback) const;
 
     bool Serialise(proto::graph::Graph &proto_graph) const;
     bool Deserialise(const proto::graph::Graph &proto_graph);
@@ -42,43 +73,306 @@ public:
 
 
 private:
+    // Строит индекс входящих явных рёбер по вершинам
+    void IndexIncomingEdges();
+    // Строит нумерацию неявных рёбер и индексы позиций по вершинам
+    void IndexLines();
+
+    size_t GetLineEnd(size_t position) const;
+    // Первый id неявных рёбер из позиции
+    EdgeId GetRowBegin(size_t position) const;
+    // Позиции неявного ребра, либо nullopt, если id не занят
+    std::optional<std::pair<size_t, size_t>> GetLinePositions(EdgeId edge_id) const;
+
+    size_t vertex_count_ = 0;
     std::vector<Edge<Weight>> edges_;
-    std::vector<IncidenceList> incidence_lists_;
+    std::vector<EdgeId> offsets_;
+    // Входящие явные рёбра вершины v занимают отрезок
+    // [incoming_offsets_[v], incoming_offsets_[v + 1]) массива incoming_edges_
+    std::vector<size_t> incoming_offsets_;
+    std::vector<EdgeId> incoming_edges_;
+
+    // Позиции линии l занимают отрезок [line_offsets_[l], line_offsets_[l + 1])
+    std::vector<size_t> line_offsets_ {0};
+    std::vector<VertexId> line_from_;
+    std::vector<VertexId> line_to_;
+    std::vector<Weight> line_prefix_weights_;
+    std::vector<size_t> position_lines_;
+    // Шаг нумерации неявных рёбер: наибольшее число рёбер из одной позиции
+    size_t line_stride_ = 0;
+    // Позиции, из которых выходят неявные рёбра вершины v, занимают
+    // отрезок [position_offsets_[v], position_offsets_[v + 1]) массива positions_
+    std::vector<size_t> position_offsets_;
+    std::vector<size_t> positions_;
+    // Позиции, в которые входят неявные рёбра вершины v, так же
+    std::vector<size_t> incoming_position_offsets_;
+    std::vector<size_t> incoming_positions_;
 };
 
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-    : incidence_lists_(vertex_count) {
+    : vertex_count_(vertex_count) {
 }
 
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+    if (IsFrozen()) {
+        throw std::logic_error("Can't add an edge to a frozen graph");
+    }
+    if (edge.from >= vertex_count_ || edge.to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
     edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
-    incidence_lists_.at(edge.from).push_back(id);
-    return id;
+    return edges_.size() - 1;
+}
+
+template <typename Weight>
+size_t DirectedWeightedGraph<Weight>::AddLine(std::vector<VertexId> from_vertices,
+                                              std::vector<VertexId> to_vertices,
+                                              std::vector<Weight> prefix_weights) {
+    if (IsFrozen()) {
+        throw std::logic_error("Can't add a line to a frozen graph");
+    }
+    if (from_vertices.size() != to_vertices.size() || from_vertices.size() != prefix_weights.size()) {
+        throw std::invalid_argument("Line positions should have equal sizes");
+    }
+    for (size_t i = 0; i < from_vertices.size(); ++i) {
+        if (from_vertices[i] >= vertex_count_ || to_vertices[i] >= vertex_count_) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+    }
+    line_from_.insert(line_from_.end(), from_vertices.begin(), from_vertices.end());
+    line_to_.insert(line_to_.end(), to_vertices.begin(), to_vertices.end());
+    line_prefix_weights_.insert(line_prefix_weights_.end(), prefix_weights.begin(), prefix_weights.end());
+    line_offsets_.push_back(line_from_.size());
+    return line_offsets_.size() - 2;
+}
+
+template <typename Weight>
+std::vector<EdgeId> DirectedWeightedGraph<Weight>::Freeze() {
+    if (IsFrozen()) {
+        throw std::logic_error("Graph is already frozen");
+    }
+
+    // Устойчивая сортировка подсчётом: порядок рёбер одной вершины сохраняется
+    offsets_.assign(vertex_count_ + 1, 0);
+    for (const auto& edge : edges_) {
+        ++offsets_[edge.from + 1];
+    }
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        offsets_[vertex + 1] += offsets_[vertex];
+    }
+
+    std::vector<EdgeId> new_ids(edges_.size());
+    std::vector<EdgeId> positions(offsets_.begin(), offsets_.end() - 1);
+    std::vector<Edge<Weight>> sorted_edges(edges_.size());
+    for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        const EdgeId new_id = positions[edges_[edge_id].from]++;
+        sorted_edges[new_id] = edges_[edge_id];
+        new_ids[edge_id] = new_id;
+    }
+    edges_ = std::move(sorted_edges);
+    IndexIncomingEdges();
+    IndexLines();
+    return new_ids;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::IndexIncomingEdges() {
+    incoming_offsets_.assign(vertex_count_ + 1, 0);
+    for (const auto& edge : edges_) {
+        ++incoming_offsets_[edge.to + 1];
+    }
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        incoming_offsets_[vertex + 1] += incoming_offsets_[vertex];
+    }
+    incoming_edges_.resize(edges_.size());
+    std::vector<size_t> next(incoming_offsets_.begin(), incoming_offsets_.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        incoming_edges_[next[edges_[edge_id].to]++] = edge_id;
+    }
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::IndexLines() {
+    const size_t position_count = line_from_.size();
+    position_lines_.resize(position_count);
+    line_stride_ = 0;
+    position_offsets_.assign(vertex_count_ + 1, 0);
+    incoming_position_offsets_.assign(vertex_count_ + 1, 0);
+    for (size_t line = 0; line + 1 < line_offsets_.size(); ++line) {
+        const size_t begin = line_offsets_[line];
+        const size_t end = line_offsets_[line + 1];
+        if (end > begin) {
+            line_stride_ = std::max(line_stride_, end - begin - 1);
+        }
+        for (size_t position = begin; position < end; ++position) {
+            position_lines_[position] = line;
+            if (position + 1 < end) {
+                ++position_offsets_[line_from_[position] + 1];
+            }
+            if (position > begin) {
+                ++incoming_position_offsets_[line_to_[position] + 1];
+            }
+        }
+    }
+
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        position_offsets_[vertex + 1] += position_offsets_[vertex];
+        incoming_position_offsets_[vertex + 1] += incoming_position_offsets_[vertex];
+    }
+    positions_.resize(position_offsets_.back());
+    incoming_positions_.resize(incoming_position_offsets_.back());
+    std::vector<size_t> next(position_offsets_.begin(), position_offsets_.end() - 1);
+    std::vector<size_t> next_incoming(incoming_position_offsets_.begin(), incoming_position_offsets_.end() - 1);
+    for (size_t position = 0; position < position_count; ++position) {
+        if (position + 1 < GetLineEnd(position)) {
+            positions_[next[line_from_[position]]++] = position;
+        }
+        if (position > line_offsets_[position_lines_[position]]) {
+            incoming_positions_[next_incoming[line_to_[position]]++] = position;
+        }
+    }
+}
+
+template <typename Weight>
+size_t DirectedWeightedGraph<Weight>::GetLineEnd(size_t position) const {
+    return line_offsets_[position_lines_[position] + 1];
+}
+
+template <typename Weight>
+EdgeId DirectedWeightedGraph<Weight>::GetRowBegin(size_t position) const {
+    return edges_.size() + position * line_stride_;
+}
+
+template <typename Weight>
+std::optional<std::pair<size_t, size_t>>
+DirectedWeightedGraph<Weight>::GetLinePositions(EdgeId edge_id) const {
+    if (edge_id < edges_.size() || edge_id >= GetEdgeIdBound()) {
+        return std::nullopt;
+    }
+    const size_t from = (edge_id - edges_.size()) / line_stride_;
+    const size_t to = from + 1 + (edge_id - edges_.size()) % line_stride_;
+    if (to >= GetLineEnd(from)) {
+        return std::nullopt;
+    }
+    return std::make_pair(from, to);
+}
+
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+    return !offsets_.empty();
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Reweight(const std::vector<Weight>& edge_weights,
+                                             std::vector<Weight> prefix_weights) {
+    if (edge_weights.size() != edges_.size() || prefix_weights.size() != line_prefix_weights_.size()) {
+        throw std::invalid_argument("Weights should match the graph topology");
+    }
+    for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        edges_[edge_id].weight = edge_weights[edge_id];
+    }
+    line_prefix_weights_ = std::move(prefix_weights);
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return vertex_count_;
+}
+
+template <typename Weight>
+EdgeId DirectedWeightedGraph<Weight>::GetEdgeIdBound() const {
+    return edges_.size() + line_from_.size() * line_stride_;
+}
+
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::HasEdge(EdgeId edge_id) const {
+    return edge_id < edges_.size() || GetLinePositions(edge_id).has_value();
+}
+
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::HasNegativeWeights() const {
+    // Неявные рёбра неотрицательны, если префиксные веса линий не убывают
+    static constexpr Weight ZERO_WEIGHT{};
+    for (const auto& edge : edges_) {
+        if (edge.weight < ZERO_WEIGHT) {
+            return true;
+        }
+    }
+    for (size_t position = 0; position < line_from_.size(); ++position) {
+        if (position + 1 < GetLineEnd(position)
+                && line_prefix_weights_[position + 1] < line_prefix_weights_[position]) {
+            return true;
+        }
+    }
+    return false;
 }
 
 template <typename Weight>
-size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
-    return edges_.size();
+Edge<Weight> DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
+    if (edge_id < edges_.size()) {
+        return edges_[edge_id];
+    }
+    const auto positions = GetLinePositions(edge_id);
+    if (!positions) {
+        throw std::out_of_range("Edge id is out of range");
+    }
+    const auto [from, to] = *positions;
+    return {line_from_[from], line_to_[to], line_prefix_weights_[to] - line_prefix_weights_[from]};
 }
 
 template <typename Weight>
-const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
-    return edges_.at(edge_id);
+std::optional<LineEdge> DirectedWeightedGraph<Weight>::GetLineEdge(EdgeId edge_id) const {
+    if (edge_id < edges_.size()) {
+        return std::nullopt;
+    }
+    const auto positions = GetLinePositions(edge_id);
+    if (!positions) {
+        throw std::out_of_range("Edge id is out of range");
+    }
+    const auto [from, to] = *positions;
+    const size_t line = position_lines_[from];
+    return LineEdge{line, from - line_offsets_[line], to - line_offsets_[line]};
 }
 
 template <typename Weight>
-typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
-DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-    return ranges::AsRange(incidence_lists_.at(vertex));
+template <typename Callback>
+void DirectedWeightedGraph<Weight>::ForEachIncidentEdge(VertexId vertex, Callback&& callback) const {
+    if (!IsFrozen()) {
+        throw std::logic_error("Graph should be frozen before traversal");
+    }
+    for (EdgeId edge_id = offsets_[vertex]; edge_id < offsets_[vertex + 1]; ++edge_id) {
+        callback(edge_id, edges_[edge_id]);
+    }
+    for (size_t i = position_offsets_[vertex]; i < position_offsets_[vertex + 1]; ++i) {
+        const size_t from = positions_[i];
+        EdgeId edge_id = GetRowBegin(from);
+        for (size_t to = from + 1; to < GetLineEnd(from); ++to, ++edge_id) {
+            callback(edge_id, Edge<Weight>{line_from_[from], line_to_[to],
+                                           line_prefix_weights_[to] - line_prefix_weights_[from]});
+        }
+    }
 }
 
+template <typename Weight>
+template <typename Callback>
+void DirectedWeightedGraph<Weight>::ForEachIncomingEdge(VertexId vertex, Callback&& callback) const {
+    if (!IsFrozen()) {
+        throw std::logic_error("Graph should be frozen before traversal");
+    }
+    for (size_t i = incoming_offsets_[vertex]; i < incoming_offsets_[vertex + 1]; ++i) {
+        const EdgeId edge_id = incoming_edges_[i];
+        callback(edge_id, edges_[edge_id]);
+    }
+    for (size_t i = incoming_position_offsets_[vertex]; i < incoming_position_offsets_[vertex + 1]; ++i) {
+        const size_t to = incoming_positions_[i];
+        for (size_t from = line_offsets_[position_lines_[to]]; from < to; ++from) {
+            callback(GetRowBegin(from) + (to - from - 1),
+                     Edge<Weight>{line_from_[from], line_to_[to],
+                                  line_prefix_weights_[to] - line_prefix_weights_[from]});
+        }
+    }
+}
 
 }  // namespace graph
@@ -0,0 +1,335 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Метки хабов (hub labels), построенные методом pruned landmark labeling.
+// У каждой вершины есть прямая метка — расстояния до хабов — и обратная —
+// расстояния от хабов. Кратчайший путь проходит через общий хаб, поэтому
+// вес маршрута находится слиянием двух меток, упорядоченных по рангу хаба.
+// Каждая запись метки хранит ребро пути к хабу, по которому путь
+// восстанавливается без поиска в графе.
+template <typename Weight>
+class HubLabelsRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    explicit HubLabelsRouter(const Graph& graph);
+    HubLabelsRouter(const Graph& graph, const proto::graph::Router& proto_router);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::vector<std::optional<Weight>>
+    BuildWeights(VertexId from, const std::vector<VertexId>& to) const override;
+    size_t GetIndexSize() const override;
+
+    bool Serialise(proto::graph::Router& proto_router) const override;
+    bool Deserialise(const proto::graph::Router& proto_router);
+
+private:
+    using CompactId = uint32_t;
+    static constexpr CompactId NO_ID = std::numeric_limits<CompactId>::max();
+
+    // Метки всех вершин одного направления в форме CSR: записи вершины v
+    // занимают отрезок [offsets[v], offsets[v + 1]) и упорядочены по рангу хаба.
+    // Ребро записи прямой метки — первое ребро пути до хаба,
+    // обратной — последнее ребро пути от хаба
+    struct Labels {
+        std::vector<size_t> offsets;
+        std::vector<CompactId> hubs;
+        std::vector<Weight> weights;
+        std::vector<CompactId> edges;
+
+        size_t Find(VertexId vertex, CompactId hub) const {
+            const auto begin = hubs.begin() + static_cast<std::ptrdiff_t>(offsets[vertex]);
+            const auto end = hubs.begin() + static_cast<std::ptrdiff_t>(offsets[vertex + 1]);
+            return static_cast<size_t>(std::lower_bound(begin, end, hub) - hubs.begin());
+        }
+
+        size_t GetSize() const {
+            return offsets.size() * sizeof(size_t)
+                   + hubs.size() * sizeof(CompactId)
+                   + weights.size() * sizeof(Weight)
+                   + edges.size() * sizeof(CompactId);
+        }
+    };
+
+    struct LabelEntry {
+        CompactId hub;
+        Weight weight;
+        CompactId edge;
+    };
+
+    // Лучший общий хаб: вес пути и записи прямой и обратной меток
+    struct Meeting {
+        Weight weight;
+        size_t forward;
+        size_t backward;
+    };
+
+    std::optional<Meeting> MergeLabels(VertexId from, VertexId to) const;
+
+    void BuildLabels();
+    static Labels Flatten(const std::vector<std::vector<LabelEntry>>& labels);
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    Labels forward_labels_;
+    Labels backward_labels_;
+};
+
+template <typename Weight>
+HubLabelsRouter<Weight>::HubLabelsRouter(const Graph& graph)
+    : graph_(graph)
+{
+    if (graph.GetVertexCount() >= NO_ID || graph.GetEdgeIdBound() >= NO_ID) {
+        throw std::length_error("Graph is too large for hub labels");
+    }
+    if (graph.HasNegativeWeights()) {
+        throw std::domain_error("Edges' weights should be non-negative");
+    }
+    BuildLabels();
+}
+
+template <typename Weight>
+void HubLabelsRouter<Weight>::BuildLabels() {
+    const size_t vertex_count = graph_.GetVertexCount();
+
+    std::vector<size_t> degrees(vertex_count, 0);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        graph_.ForEachIncidentEdge(vertex, [&degrees](EdgeId, const Edge<Weight>& edge) {
+            ++degrees[edge.from];
+            ++degrees[edge.to];
+        });
+    }
+
+    // Хабами раньше становятся вершины с большей степенью:
+    // через них проходит больше кратчайших путей
+    std::vector<VertexId> order(vertex_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&degrees](VertexId lhs, VertexId rhs) {
+        return degrees[lhs] > degrees[rhs];
+    });
+
+    std::vector<std::vector<LabelEntry>> forward_labels(vertex_count);
+    std::vector<std::vector<LabelEntry>> backward_labels(vertex_count);
+
+    std::vector<std::optional<Weight>> weights(vertex_count);
+    std::vector<CompactId> edges(vertex_count, NO_ID);
+    std::vector<VertexId> touched;
+    // Расстояния от текущего хаба (или до него) до прежних хабов по его метке
+    std::vector<std::optional<Weight>> hub_weights(vertex_count);
+
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    // Поиск от хаба с отсечением: вершина не получает запись, если путь
+    // той же длины уже покрыт метками прежних хабов
+    const auto pruned_search = [&](CompactId rank, bool is_forward) {
+        const VertexId hub = order[rank];
+        auto& hub_label = is_forward ? forward_labels[hub] : backward_labels[hub];
+        auto& target_labels = is_forward ? backward_labels : forward_labels;
+        for (const LabelEntry& entry : hub_label) {
+            hub_weights[entry.hub] = entry.weight;
+        }
+
+        Queue queue;
+        weights[hub] = ZERO_WEIGHT;
+        touched.push_back(hub);
+        queue.emplace(ZERO_WEIGHT, hub);
+        while (!queue.empty()) {
+            const Weight weight = queue.top().first;
+            const VertexId vertex = queue.top().second;
+            queue.pop();
+            if (weight != *weights[vertex]) {
+                continue;
+            }
+            if (vertex != hub) {
+                const bool is_covered = std::any_of(
+                            target_labels[vertex].begin(), target_labels[vertex].end(),
+                            [&](const LabelEntry& entry) {
+                    return hub_weights[entry.hub] && !(weight < *hub_weights[entry.hub] + entry.weight);
+                });
+                if (is_covered) {
+                    continue;
+                }
+            }
+            target_labels[vertex].push_back({rank, weight, edges[vertex]});
+
+            const auto relax = [&](EdgeId edge_id, VertexId next, Weight edge_weight) {
+                const Weight candidate_weight = weight + edge_weight;
+                auto& weight_next = weights[next];
+                if (!weight_next) {
+                    touched.push_back(next);
+                } else if (!(candidate_weight < *weight_next)) {
+                    return;
+                }
+                weight_next = candidate_weight;
+                edges[next] = static_cast<CompactId>(edge_id);
+                queue.emplace(candidate_weight, next);
+            };
+            if (is_forward) {
+                graph_.ForEachIncidentEdge(vertex, [&relax](EdgeId edge_id, const Edge<Weight>& edge) {
+                    relax(edge_id, edge.to, edge.weight);
+                });
+            } else {
+                graph_.ForEachIncomingEdge(vertex, [&relax](EdgeId edge_id, const Edge<Weight>& edge) {
+                    relax(edge_id, edge.from, edge.weight);
+                });
+            }
+        }
+
+        for (const VertexId vertex : touched) {
+            weights[vertex].reset();
+            edges[vertex] = NO_ID;
+        }
+        touched.clear();
+        for (const LabelEntry& entry : hub_label) {
+            hub_weights[entry.hub].reset();
+        }
+    };
+
+    for (CompactId rank = 0; rank < vertex_count; ++rank) {
+        pruned_search(rank, true);
+        pruned_search(rank, false);
+    }
+
+    forward_labels_ = Flatten(forward_labels);
+    backward_labels_ = Flatten(backward_labels);
+}
+
+template <typename Weight>
+typename HubLabelsRouter<Weight>::Labels
+HubLabelsRouter<Weight>::Flatten(const std::vector<std::vector<LabelEntry>>& labels) {
+    Labels result;
+    result.offsets.reserve(labels.size() + 1);
+    result.offsets.push_back(0);
+    for (const auto& label : labels) {
+        for (const LabelEntry& entry : label) {
+            result.hubs.push_back(entry.hub);
+            result.weights.push_back(entry.weight);
+            result.edges.push_back(entry.edge);
+        }
+        result.offsets.push_back(result.hubs.size());
+    }
+    return result;
+}
+
+template <typename Weight>
+std::optional<typename HubLabelsRouter<Weight>::Meeting>
+HubLabelsRouter<Weight>::MergeLabels(VertexId from, VertexId to) const
+{
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    // Слияние меток, упорядоченных по рангу хаба
+    std::optional<Meeting> best;
+    size_t forward = forward_labels_.offsets[from];
+    size_t backward = backward_labels_.offsets[to];
+    while (forward < forward_labels_.offsets[from + 1] && backward < backward_labels_.offsets[to + 1]) {
+        const CompactId forward_hub = forward_labels_.hubs[forward];
+        const CompactId backward_hub = backward_labels_.hubs[backward];
+        if (forward_hub < backward_hub) {
+            ++forward;
+        } else if (backward_hub < forward_hub) {
+            ++backward;
+        } else {
+            const Weight weight = forward_labels_.weights[forward] + backward_labels_.weights[backward];
+            if (!best || weight < best->weight) {
+                best = Meeting{weight, forward, backward};
+            }
+            ++forward;
+            ++backward;
+        }
+    }
+    return best;
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>>
+HubLabelsRouter<Weight>::BuildWeights(VertexId from, const std::vector<VertexId>& to) const
+{
+    std::vector<std::optional<Weight>> weights;
+    weights.reserve(to.size());
+    for (const VertexId target : to) {
+        const auto meeting = MergeLabels(from, target);
+        if (from == target) {
+            weights.push_back(ZERO_WEIGHT);
+        } else {
+            weights.push_back(meeting ? std::optional<Weight>(meeting->weight) : std::nullopt);
+        }
+    }
+    return weights;
+}
+
+template <typename Weight>
+std::optional<typename HubLabelsRouter<Weight>::RouteInfo>
+HubLabelsRouter<Weight>::BuildRoute(VertexId from, VertexId to) const
+{
+    const auto meeting = MergeLabels(from, to);
+    if (from == to) {
+        return RouteInfo{ZERO_WEIGHT, {}};
+    }
+    if (!meeting) {
+        return std::nullopt;
+    }
+
+    // От начала к хабу по первым рёбрам прямых меток,
+    // от цели к хабу по последним рёбрам обратных
+    const CompactId hub = forward_labels_.hubs[meeting->forward];
+    // Каждая вершина пути до хаба хранит запись о нём, а путь проходит
+    // вершину не больше одного раза; иначе метки из базы испорчены
+    const size_t vertex_count = graph_.GetVertexCount();
+    const auto find_entry = [hub](const Labels& labels, VertexId vertex) {
+        const size_t entry = labels.Find(vertex, hub);
+        if (entry == labels.offsets[vertex + 1] || labels.hubs[entry] != hub) {
+            throw std::logic_error("Hub labels are inconsistent");
+        }
+        return entry;
+    };
+    std::vector<EdgeId> edges;
+    for (size_t entry = meeting->forward; forward_labels_.edges[entry] != NO_ID;) {
+        const EdgeId edge_id = forward_labels_.edges[entry];
+        edges.push_back(edge_id);
+        if (edges.size() >= vertex_count) {
+            throw std::logic_error("Hub labels are inconsistent");
+        }
+        entry = find_entry(forward_labels_, graph_.GetEdge(edge_id).to);
+    }
+    std::vector<EdgeId> edges_from_hub;
+    for (size_t entry = meeting->backward; backward_labels_.edges[entry] != NO_ID;) {
+        const EdgeId edge_id = backward_labels_.edges[entry];
+        edges_from_hub.push_back(edge_id);
+        if (edges_from_hub.size() >= vertex_count) {
+            throw std::logic_error("Hub labels are inconsistent");
+        }
+        entry = find_entry(backward_labels_, graph_.GetEdge(edge_id).from);
+    }
+    edges.insert(edges.end(), edges_from_hub.rbegin(), edges_from_hub.rend());
+
+    return RouteInfo{meeting->weight, std::move(edges)};
+}
+
+template <typename Weight>
+size_t HubLabelsRouter<Weight>::GetIndexSize() const {
+    return forward_labels_.GetSize() + backward_labels_.GetSize();
+}
+
+}  // namespace graph
@@ -60,6 +60,23 @@ std::vector<Query> Reader::GetQueries() const {
                                  req.AsDict().at("from"s).AsString(),
                                  req.AsDict().at("to"s).AsString()
                                  });
+        } else if (type == "Reachable"sv) {
+            queries.emplace_back(ReachableQuery {id,
+                                 req.AsDict().at("from"s).AsString(),
+                                 req.AsDict().at("max_time"s).AsDouble()
+                                 });
+        } else if (type == "RouteMatrix"sv) {
+            const auto to_names = [](const json::Node& node) {
+                std::vector<std::string> names;
+                for (const json::Node& name : node.AsArray()) {
+                    names.push_back(name.AsString());
+                }
+                return names;
+            };
+            queries.emplace_back(RouteMatrixQuery {id,
+                                 to_names(req.AsDict().at("from"s)),
+                                 to_names(req.AsDict().at("to"s))
+                                 });
         }
     }
     return queries;
@@ -77,4 +94,8 @@ RoutingSettings Reader::GetRoutingSettings() const {
     return RoutingSettings(GetNodeByKey("routing_settings"s));
 }
 
+bool Reader::HasRoutingSettings() const {
+    return GetNodeByKey("routing_settings"s).IsDict();
+}
+
 }
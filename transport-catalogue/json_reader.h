@@ -10,7 +10,7 @@
 #include <string_view>
 #include <vector>
 
-using Query = std::variant<BusQuery, StopQuery, MapQuery, RouteQuery>;
+using Query = std::variant<BusQuery, StopQuery, MapQuery, RouteQuery, RouteMatrixQuery, ReachableQuery>;
 
 namespace json {
 
@@ -24,6 +24,7 @@ public:
     RenderSettings GetRenderSettings() const;
     SerializationSettings GetSerializationSettings() const;
     RoutingSettings GetRoutingSettings() const;
+    bool HasRoutingSettings() const;
 
 private:
     json::Document m_json;
@@ -15,11 +15,11 @@ bool IsZero(double value) {
 
 } //namespace sphere
 
-std::unique_ptr<Info> MapQuery::Request(const MapRenderer& renderer) const
+Info MapQuery::Request(const MapRenderer& renderer) const
 {
     std::stringstream ssout;
     renderer.Draw(ssout);
-    return std::make_unique<MapInfo>(ssout.str());
+    return MapInfo(ssout.str());
 }
 
 void MapRenderer::SetSettings(const RenderSettings& settings) {
@@ -119,5 +119,5 @@ private:
 
 struct MapQuery {
     int request_id;
-    std::unique_ptr<Info> Request(const MapRenderer& renderer) const;
+    Info Request(const MapRenderer& renderer) const;
 };
@@ -0,0 +1,99 @@
+#include "min_plus_kernel.h"
+
+#ifdef MIN_PLUS_KERNEL_AVX2
+#include <immintrin.h>
+#endif
+
+namespace graph::detail {
+
+namespace {
+
+using RelaxRowFunction = void (*)(double, const double*, const uint32_t*,
+                                  double*, uint32_t*, size_t);
+
+RelaxRowFunction SelectRelaxRow() {
+#ifdef MIN_PLUS_KERNEL_AVX2
+    if (IsAvx2Supported()) {
+        return RelaxRowAvx2;
+    }
+#endif
+    return RelaxRowScalar;
+}
+
+}  // namespace
+
+void RelaxRowScalar(double weight_from,
+                    const double* weights_through,
+                    const uint32_t* prev_edges_through,
+                    double* weights_row,
+                    uint32_t* prev_edges_row,
+                    size_t count)
+{
+    for (size_t j = 0; j < count; ++j) {
+        const double candidate_weight = weight_from + weights_through[j];
+        if (candidate_weight < weights_row[j]) {
+            weights_row[j] = candidate_weight;
+            prev_edges_row[j] = prev_edges_through[j];
+        }
+    }
+}
+
+#ifdef MIN_PLUS_KERNEL_AVX2
+__attribute__((target("avx2")))
+void RelaxRowAvx2(double weight_from,
+                  const double* weights_through,
+                  const uint32_t* prev_edges_through,
+                  double* weights_row,
+                  uint32_t* prev_edges_row,
+                  size_t count)
+{
+    const __m256d from = _mm256_set1_pd(weight_from);
+    // Переставляет младшие половины 64-битных масок в 32-битные элементы
+    const __m256i compress_mask = _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0);
+
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        const __m256d candidate = _mm256_add_pd(from, _mm256_loadu_pd(weights_through + j));
+        const __m256d current = _mm256_loadu_pd(weights_row + j);
+        const __m256d mask = _mm256_cmp_pd(candidate, current, _CMP_LT_OQ);
+        if (_mm256_testz_pd(mask, mask)) {
+            continue;
+        }
+        _mm256_storeu_pd(weights_row + j, _mm256_blendv_pd(current, candidate, mask));
+
+        const __m128i prev_mask = _mm256_castsi256_si128(
+                    _mm256_permutevar8x32_epi32(_mm256_castpd_si256(mask), compress_mask));
+        auto* prev_row = reinterpret_cast<__m128i*>(prev_edges_row + j);
+        const auto* prev_through = reinterpret_cast<const __m128i*>(prev_edges_through + j);
+        _mm_storeu_si128(prev_row, _mm_blendv_epi8(_mm_loadu_si128(prev_row),
+                                                   _mm_loadu_si128(prev_through),
+                                                   prev_mask));
+    }
+
+    RelaxRowScalar(weight_from, weights_through + j, prev_edges_through + j,
+                   weights_row + j, prev_edges_row + j, count - j);
+}
+#endif
+
+bool IsAvx2Supported() {
+#ifdef MIN_PLUS_KERNEL_AVX2
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+void RelaxRowMinPlus(double weight_from,
+                     const double* weights_through,
+                     const uint32_t* prev_edges_through,
+                     double* weights_row,
+                     uint32_t* prev_edges_row,
+                     size_t count)
+{
+    static const RelaxRowFunction relax_row = SelectRelaxRow();
+    relax_row(weight_from, weights_through, prev_edges_through,
+              weights_row, prev_edges_row, count);
+}
+
+}  // namespace graph::detail
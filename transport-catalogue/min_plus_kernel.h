@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MIN_PLUS_KERNEL_AVX2
+#endif
+
+namespace graph::detail {
+
+// Релаксация строки таблицы кратчайших путей через промежуточную вершину:
+// weights_row[j] = min(weights_row[j], weight_from + weights_through[j]).
+// При строгом улучшении prev_edges_row[j] = prev_edges_through[j].
+// Недостижимые ячейки хранят +inf, поэтому проверки на достижимость не нужны.
+// Реализация AVX2 выбирается во время выполнения, если процессор её поддерживает,
+// иначе используется скалярный цикл. Результаты обеих версий совпадают побитово.
+void RelaxRowMinPlus(double weight_from,
+                     const double* weights_through,
+                     const uint32_t* prev_edges_through,
+                     double* weights_row,
+                     uint32_t* prev_edges_row,
+                     size_t count);
+
+// Отдельные реализации RelaxRowMinPlus, открыты для сравнения в бенчмарке
+void RelaxRowScalar(double weight_from,
+                    const double* weights_through,
+                    const uint32_t* prev_edges_through,
+                    double* weights_row,
+                    uint32_t* prev_edges_row,
+                    size_t count);
+
+#ifdef MIN_PLUS_KERNEL_AVX2
+// Вызывать можно, только если IsAvx2Supported()
+void RelaxRowAvx2(double weight_from,
+                  const double* weights_through,
+                  const uint32_t* prev_edges_through,
+                  double* weights_row,
+                  uint32_t* prev_edges_row,
+                  size_t count);
+#endif
+
+bool IsAvx2Supported();
+
+}  // namespace graph::detail
@@ -0,0 +1,121 @@
+#include "name_index.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// Финализатор splitmix64
+uint64_t Mix(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+// Отображает старшие биты хеша на [0, size) умножением
+size_t Scale(uint64_t hash, size_t size) {
+    return static_cast<size_t>(((hash >> 32) * size) >> 32);
+}
+
+} // namespace
+
+void NameIndex::Build(const std::vector<std::string_view>& names) {
+    // Номера различных названий; при повторе остаётся меньший номер
+    std::vector<uint32_t> ids(names.size());
+    std::iota(ids.begin(), ids.end(), 0);
+    std::stable_sort(ids.begin(), ids.end(), [&names](uint32_t lhs, uint32_t rhs) {
+        return names[lhs] < names[rhs];
+    });
+    ids.erase(std::unique(ids.begin(), ids.end(), [&names](uint32_t lhs, uint32_t rhs) {
+        return names[lhs] == names[rhs];
+    }), ids.end());
+
+    // Смещения подбираются для хешей с конкретным зерном: если
+    // для какой-то корзины подходящего смещения нет, зерно меняется
+    m_seed = 0;
+    while (!TryBuild(names, ids)) {
+        ++m_seed;
+    }
+}
+
+bool NameIndex::TryBuild(const std::vector<std::string_view>& names,
+                         const std::vector<uint32_t>& ids) {
+    const size_t slot_count {ids.size()};
+    m_ids.assign(slot_count, NO_ID);
+    if (slot_count == 0) {
+        m_displacements.clear();
+        return true;
+    }
+    m_displacements.assign(std::max<size_t>(1, slot_count / BUCKET_SIZE), 0);
+
+    // Названия корзин в форме CSR
+    std::vector<uint64_t> hashes(slot_count);
+    std::vector<size_t> offsets(m_displacements.size() + 1, 0);
+    for (size_t i {0}; i < slot_count; ++i) {
+        hashes[i] = Hash(names[ids[i]]);
+        ++offsets[GetBucket(hashes[i]) + 1];
+    }
+    for (size_t bucket {0}; bucket < m_displacements.size(); ++bucket) {
+        offsets[bucket + 1] += offsets[bucket];
+    }
+    std::vector<size_t> members(slot_count);
+    std::vector<size_t> positions(offsets.begin(), offsets.end() - 1);
+    for (size_t i {0}; i < slot_count; ++i) {
+        members[positions[GetBucket(hashes[i])]++] = i;
+    }
+
+    // Большие корзины размещаются первыми, пока свободных ячеек много
+    std::vector<size_t> buckets(m_displacements.size());
+    std::iota(buckets.begin(), buckets.end(), 0);
+    std::stable_sort(buckets.begin(), buckets.end(), [&offsets](size_t lhs, size_t rhs) {
+        return offsets[lhs + 1] - offsets[lhs] > offsets[rhs + 1] - offsets[rhs];
+    });
+
+    std::vector<size_t> slots;
+    for (const size_t bucket : buckets) {
+        if (offsets[bucket] == offsets[bucket + 1]) {
+            break;
+        }
+        bool is_placed {false};
+        for (uint32_t displacement {0}; !is_placed && displacement < MAX_ATTEMPTS; ++displacement) {
+            slots.clear();
+            is_placed = true;
+            for (size_t member {offsets[bucket]}; member < offsets[bucket + 1]; ++member) {
+                const size_t slot {GetSlot(hashes[members[member]], displacement)};
+                if (m_ids[slot] != NO_ID || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                    is_placed = false;
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (is_placed) {
+                m_displacements[bucket] = displacement;
+                for (size_t i {0}; i < slots.size(); ++i) {
+                    m_ids[slots[i]] = ids[members[offsets[bucket] + i]];
+                }
+            }
+        }
+        if (!is_placed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t NameIndex::Hash(std::string_view name) const {
+    // FNV-1a: хеш не зависит от реализации стандартной библиотеки
+    // и остаётся верным для индекса, сохранённого в базе
+    uint64_t hash {0xcbf29ce484222325ULL ^ Mix(m_seed)};
+    for (const char c : name) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+    }
+    return Mix(hash);
+}
+
+size_t NameIndex::GetBucket(uint64_t hash) const {
+    return Scale(hash, m_displacements.size());
+}
+
+size_t NameIndex::GetSlot(uint64_t hash, uint32_t displacement) const {
+    return Scale(Mix(hash ^ (displacement * 0x9e3779b97f4a7c15ULL)), m_ids.size());
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <transport_catalogue.pb.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Минимальная совершенная хеш-функция по неизменному набору названий
+// (hash and displace). Названия разложены по корзинам, и для каждой корзины
+// подобрано смещение, при котором её названия попадают в свободные ячейки.
+// Ячеек столько же, сколько различных названий, в ячейке хранится номер.
+// Поиск — один хеш строки и одно сравнение с названием по найденному номеру
+class NameIndex
+{
+public:
+    // names[id] — название с номером id; из повторяющихся названий
+    // в индекс попадает первое
+    void Build(const std::vector<std::string_view>& names);
+
+    // get_name(id) возвращает название по номеру
+    template <typename GetName>
+    std::optional<uint32_t> Find(std::string_view name, GetName&& get_name) const;
+
+    bool Serialize(proto::NameIndex& proto_index) const;
+    // Возвращает false, если индекс в базе не подходит к name_count названиям
+    bool Deserialize(const proto::NameIndex& proto_index, size_t name_count);
+
+private:
+    static constexpr uint32_t NO_ID {std::numeric_limits<uint32_t>::max()};
+    // Число попыток подобрать смещение корзины до смены зерна хеша
+    static constexpr uint32_t MAX_ATTEMPTS {1u << 20};
+    // Среднее число названий в корзине
+    static constexpr size_t BUCKET_SIZE {2};
+
+    bool TryBuild(const std::vector<std::string_view>& names,
+                  const std::vector<uint32_t>& ids);
+
+    uint64_t Hash(std::string_view name) const;
+    size_t GetBucket(uint64_t hash) const;
+    size_t GetSlot(uint64_t hash, uint32_t displacement) const;
+
+    uint64_t m_seed {0};
+    std::vector<uint32_t> m_displacements;
+    std::vector<uint32_t> m_ids;
+};
+
+template <typename GetName>
+std::optional<uint32_t> NameIndex::Find(std::string_view name, GetName&& get_name) const {
+    if (m_ids.empty()) {
+        return std::nullopt;
+    }
+    const uint64_t hash {Hash(name)};
+    const uint32_t id {m_ids[GetSlot(hash, m_displacements[GetBucket(hash)])]};
+    if (get_name(id) != name) {
+        return std::nullopt;
+    }
+    return id;
+}
@@ -0,0 +1,240 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+
+namespace transport {
+
+RaptorRouter::RaptorRouter(const TransportCatalogue& catalogue,
+                           const RoutingSettings& settings)
+    : m_transport_catalogue {catalogue},
+      m_settings {settings}
+{
+    BuildStops(catalogue.GetStops());
+    BuildLines(catalogue.GetBuses());
+}
+
+Info
+RaptorRouter::BuildRoute(std::string_view from,
+                         std::string_view to) const
+{
+    const size_t stop_to {m_transport_catalogue.GetStopId(to)};
+    return ExtractRoute(Search(m_transport_catalogue.GetStopId(from), stop_to), stop_to);
+}
+
+std::vector<Info>
+RaptorRouter::BuildRoutes(std::string_view from,
+                          const std::vector<std::string_view>& to) const
+{
+    const Rounds rounds {Search(m_transport_catalogue.GetStopId(from), NO_STOP)};
+    std::vector<Info> routes;
+    routes.reserve(to.size());
+    for (const std::string_view target : to) {
+        routes.push_back(ExtractRoute(rounds, m_transport_catalogue.GetStopId(target)));
+    }
+    return routes;
+}
+
+std::vector<std::optional<double>>
+RaptorRouter::BuildTimes(std::string_view from,
+                         const std::vector<std::string_view>& to) const
+{
+    const Rounds rounds {Search(m_transport_catalogue.GetStopId(from), NO_STOP)};
+    std::vector<std::optional<double>> times;
+    times.reserve(to.size());
+    for (const std::string_view target : to) {
+        const double arrival {rounds.best_arrivals[m_transport_catalogue.GetStopId(target)]};
+        times.push_back(arrival == UNREACHABLE ? std::nullopt : std::make_optional(arrival));
+    }
+    return times;
+}
+
+std::vector<ReachableInfo::Item>
+RaptorRouter::BuildReachable(std::string_view from, double max_time) const
+{
+    std::vector<ReachableInfo::Item> reachable;
+    if (max_time < 0.0) {
+        return reachable;
+    }
+    const Rounds rounds {Search(m_transport_catalogue.GetStopId(from), NO_STOP, max_time)};
+    std::vector<size_t> stops;
+    for (size_t stop {0}; stop < m_stops.size(); ++stop) {
+        if (rounds.best_arrivals[stop] != UNREACHABLE) {
+            stops.push_back(stop);
+        }
+    }
+    std::sort(stops.begin(), stops.end(), [&rounds](size_t lhs, size_t rhs) {
+        return std::pair(rounds.best_arrivals[lhs], lhs) < std::pair(rounds.best_arrivals[rhs], rhs);
+    });
+    reachable.reserve(stops.size());
+    for (const size_t stop : stops) {
+        reachable.push_back({m_stops[stop]->name, rounds.best_arrivals[stop]});
+    }
+    return reachable;
+}
+
+RaptorRouter::Rounds RaptorRouter::Search(size_t stop_from, size_t stop_target, double max_arrival) const {
+    const size_t stops_count {m_stops.size()};
+
+    Rounds rounds {std::vector<double>(stops_count, UNREACHABLE),
+                   {std::vector<double>(stops_count, UNREACHABLE)},
+                   {std::vector<Trip>(stops_count)}};
+    auto& best_arrivals {rounds.best_arrivals};
+    rounds.arrivals[0][stop_from] = 0.0;
+    best_arrivals[stop_from] = 0.0;
+
+    // Если цель задана, отбрасываем прибытия не лучше уже найденного до неё
+    auto target_arrival = [&best_arrivals, stop_target]() {
+        return stop_target == NO_STOP ? UNREACHABLE : best_arrivals[stop_target];
+    };
+
+    std::vector<size_t> marked_stops {stop_from};
+    std::vector<size_t> line_starts(m_lines.size(), NO_LINE);
+    std::vector<size_t> marked_lines;
+    std::vector<bool> is_marked(stops_count, false);
+
+    while (!marked_stops.empty()) {
+        // Для каждой линии запоминаем самую раннюю позицию посадки
+        for (const size_t stop : marked_stops) {
+            for (size_t index {m_occurrence_offsets[stop]};
+                 index < m_occurrence_offsets[stop + 1]; ++index) {
+                const auto& [line, position] {m_occurrences[index]};
+                if (line_starts[line] == NO_LINE) {
+                    marked_lines.push_back(line);
+                    line_starts[line] = position;
+                } else {
+                    line_starts[line] = std::min(line_starts[line], position);
+                }
+            }
+        }
+        marked_stops.clear();
+
+        const auto& prev_arrivals {rounds.arrivals.back()};
+        std::vector<double> round_arrivals {prev_arrivals};
+        std::vector<Trip> round_trips(stops_count);
+
+        for (const size_t line_id : marked_lines) {
+            const Line& line {m_lines[line_id]};
+            size_t board {NO_LINE};
+            double board_time {UNREACHABLE};
+            for (size_t position {line.begin + line_starts[line_id]};
+                 position < line.end; ++position) {
+                const size_t stop {m_line_stops[position]};
+                if (board != NO_LINE) {
+                    const double arrival {board_time + GetRideTime(board, position)};
+                    if (arrival < std::min(best_arrivals[stop], target_arrival())
+                            && arrival <= max_arrival) {
+                        round_arrivals[stop] = arrival;
+                        best_arrivals[stop] = arrival;
+                        round_trips[stop] = {line_id, board - line.begin, position - line.begin};
+                        if (!is_marked[stop]) {
+                            is_marked[stop] = true;
+                            marked_stops.push_back(stop);
+                        }
+                    }
+                }
+                // Садимся здесь, если так выходит быстрее, чем уже ехать в автобусе
+                if (prev_arrivals[stop] == UNREACHABLE) {
+                    continue;
+                }
+                const double wait_time {prev_arrivals[stop] + m_settings.bus_wait_time};
+                if (board == NO_LINE || wait_time < board_time + GetRideTime(board, position)) {
+                    board = position;
+                    board_time = wait_time;
+                }
+            }
+            line_starts[line_id] = NO_LINE;
+        }
+        marked_lines.clear();
+
+        for (const size_t stop : marked_stops) {
+            is_marked[stop] = false;
+        }
+        rounds.arrivals.push_back(std::move(round_arrivals));
+        rounds.trips.push_back(std::move(round_trips));
+    }
+
+    return rounds;
+}
+
+Info RaptorRouter::ExtractRoute(const Rounds& rounds, size_t stop_to) const {
+    const double best_arrival {rounds.best_arrivals[stop_to]};
+    if (best_arrival == UNREACHABLE) {
+        return ErrorInfo{};
+    }
+
+    // Первый раунд, на котором достигнуто лучшее время, даёт меньше пересадок
+    size_t round {0};
+    while (rounds.arrivals[round][stop_to] != best_arrival) {
+        ++round;
+    }
+
+    std::vector<RouteInfo::RouteItem> reversed_items;
+    for (size_t stop {stop_to}; round > 0; --round) {
+        const Trip& trip {rounds.trips[round][stop]};
+        if (trip.line == NO_LINE) {
+            continue;
+        }
+        const Line& line {m_lines[trip.line]};
+        const size_t board {line.begin + trip.board};
+        const size_t alight {line.begin + trip.alight};
+        reversed_items.push_back({line.bus->name, false, GetRideTime(board, alight),
+                                  trip.alight - trip.board});
+        stop = m_line_stops[board];
+        reversed_items.push_back({m_stops[stop]->name, true,
+                                  static_cast<double>(m_settings.bus_wait_time)});
+    }
+
+    return RouteInfo(best_arrival,
+                      std::vector<RouteInfo::RouteItem>(reversed_items.rbegin(),
+                                                        reversed_items.rend()));
+}
+
+void RaptorRouter::BuildStops(const std::deque<Stop>& stops) {
+    m_stops.reserve(stops.size());
+    for (const auto& stop : stops) {
+        m_stops.push_back(&stop);
+    }
+}
+
+void RaptorRouter::BuildLines(const std::deque<Bus>& buses) {
+    for (const auto& bus : buses) {
+        Line line {&bus, m_line_stops.size(), m_line_stops.size() + bus.stops.size()};
+        double distance {0.0};
+        for (auto it {bus.stops.cbegin()}; it != bus.stops.cend(); ++it) {
+            if (it != bus.stops.cbegin()) {
+                distance += m_transport_catalogue.GetDistance((*std::prev(it))->id, (*it)->id);
+            }
+            const size_t stop {(*it)->id};
+            m_line_stops.push_back(stop);
+            m_line_distances.push_back(distance);
+        }
+        m_lines.push_back(line);
+    }
+
+    // Индекс посадок: для каждой остановки её позиции на линиях.
+    // С последней остановки линии уехать нельзя, её не учитываем
+    m_occurrence_offsets.assign(m_stops.size() + 1, 0);
+    for (const Line& line : m_lines) {
+        for (size_t position {line.begin}; position + 1 < line.end; ++position) {
+            ++m_occurrence_offsets[m_line_stops[position] + 1];
+        }
+    }
+    for (size_t stop {0}; stop < m_stops.size(); ++stop) {
+        m_occurrence_offsets[stop + 1] += m_occurrence_offsets[stop];
+    }
+    std::vector<size_t> positions(m_occurrence_offsets.begin(), m_occurrence_offsets.end() - 1);
+    m_occurrences.resize(m_occurrence_offsets.back());
+    for (size_t line_id {0}; line_id < m_lines.size(); ++line_id) {
+        const Line& line {m_lines[line_id]};
+        for (size_t position {line.begin}; position + 1 < line.end; ++position) {
+            const size_t stop {m_line_stops[position]};
+            m_occurrences[positions[stop]++] = {line_id, position - line.begin};
+        }
+    }
+}
+
+double RaptorRouter::GetRideTime(size_t begin, size_t end) const {
+    return m_settings.GetRideTime(m_line_distances[end] - m_line_distances[begin]);
+}
+
+} // namespace transport
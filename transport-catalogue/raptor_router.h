@@ -0,0 +1,86 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <limits>
+#include <string_view>
+#include <vector>
+
+namespace transport {
+
+// Поиск маршрута по раундам в духе RAPTOR прямо по последовательностям
+// остановок автобусов, без графа поездок между всеми парами остановок.
+// Раунд k находит лучшее время прибытия на остановки ровно за k посадок.
+// Время поездки считается по префиксным суммам дорожного расстояния линии,
+// поэтому память линейна по суммарной длине маршрутов.
+class RaptorRouter
+{
+public:
+    RaptorRouter(const TransportCatalogue& catalogue, const RoutingSettings& settings);
+
+    Info BuildRoute(std::string_view from,
+                    std::string_view to) const;
+
+    // Один поиск без отсечения по цели отвечает сразу на все цели
+    std::vector<Info> BuildRoutes(std::string_view from,
+                                  const std::vector<std::string_view>& to) const;
+
+    // Только время в пути из одной остановки в несколько
+    std::vector<std::optional<double>> BuildTimes(std::string_view from,
+                                                  const std::vector<std::string_view>& to) const;
+
+    // Остановки, до которых можно доехать не дольше max_time, по возрастанию времени
+    std::vector<ReachableInfo::Item> BuildReachable(std::string_view from, double max_time) const;
+
+private:
+    struct Line {
+        BusPtrConst bus {nullptr};
+        size_t begin {0};
+        size_t end {0};
+    };
+
+    struct Occurrence {
+        size_t line {0};
+        size_t position {0};
+    };
+
+    // Поездка, которой остановка была достигнута в текущем раунде
+    struct Trip {
+        size_t line {NO_LINE};
+        size_t board {0};
+        size_t alight {0};
+    };
+
+    // Времена прибытия и поездки по всем раундам поиска
+    struct Rounds {
+        std::vector<double> best_arrivals;
+        std::vector<std::vector<double>> arrivals;
+        std::vector<std::vector<Trip>> trips;
+    };
+
+    static constexpr size_t NO_LINE {std::numeric_limits<size_t>::max()};
+    static constexpr size_t NO_STOP {std::numeric_limits<size_t>::max()};
+    static constexpr double UNREACHABLE {std::numeric_limits<double>::infinity()};
+
+    // Прибытия позже max_arrival не рассматриваются
+    Rounds Search(size_t stop_from, size_t stop_target, double max_arrival = UNREACHABLE) const;
+    Info ExtractRoute(const Rounds& rounds, size_t stop_to) const;
+
+    void BuildStops(const std::deque<Stop>& stops);
+    void BuildLines(const std::deque<Bus>& buses);
+
+    double GetRideTime(size_t begin, size_t end) const;
+
+    const TransportCatalogue& m_transport_catalogue;
+    RoutingSettings m_settings;
+    // Остановки по StopId
+    std::vector<StopPtrConst> m_stops;
+    std::vector<Line> m_lines;
+    std::vector<size_t> m_line_stops;
+    std::vector<double> m_line_distances;
+    std::vector<size_t> m_occurrence_offsets;
+    std::vector<Occurrence> m_occurrences;
+};
+
+} // namespace transport
@@ -1,8 +1,10 @@
 #include "request_handler.h"
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 #include <variant>
 
@@ -14,19 +16,27 @@ struct QueryVisitor {
     const transport::Router& router;
 
     json::Node operator()(const BusQuery& query) {
-        return query.Request(catalogue).get()->ToJSON(query.request_id);
+        return ToJSON(query.Request(catalogue), query.request_id);
     }
 
     json::Node operator()(const StopQuery& query) {
-        return query.Request(catalogue).get()->ToJSON(query.request_id);
+        return ToJSON(query.Request(catalogue), query.request_id);
     }
 
     json::Node operator()(const MapQuery& query) {
-        return query.Request(renderer).get()->ToJSON(query.request_id);
+        return ToJSON(query.Request(renderer), query.request_id);
     }
 
     json::Node operator()(const RouteQuery& query) {
-        return query.Request(router).get()->ToJSON(query.request_id);
+        return ToJSON(query.Request(router), query.request_id);
+    }
+
+    json::Node operator()(const RouteMatrixQuery& query) {
+        return ToJSON(query.Request(router), query.request_id);
+    }
+
+    json::Node operator()(const ReachableQuery& query) {
+        return ToJSON(query.Request(router), query.request_id);
     }
 };
 
@@ -42,19 +52,62 @@ void RequestHandler::ProcessBaseRequests()
 
     m_transport_catalogue.AddStops(stops);
     m_transport_catalogue.AddBuses(buses);
-    m_router.BuildGraph();
+}
+
+void RequestHandler::ProcessRouteQueries(const std::vector<Query>& queries,
+                                         json::Array& results) const
+{
+    // Запросы маршрутов группируются по остановке отправления,
+    // чтобы на каждую остановку выполнялся один поиск
+    std::vector<std::string_view> origins;
+    std::unordered_map<std::string_view, std::vector<size_t>> origin_to_queries;
+    for (size_t index {0}; index < queries.size(); ++index) {
+        if (const auto* query = std::get_if<RouteQuery>(&queries[index])) {
+            auto& group {origin_to_queries[query->from]};
+            if (group.empty()) origins.push_back(query->from);
+            group.push_back(index);
+        }
+    }
+
+    for (const std::string_view from : origins) {
+        const auto& group {origin_to_queries.at(from)};
+        std::vector<std::string_view> targets;
+        targets.reserve(group.size());
+        for (const size_t index : group) {
+            targets.push_back(std::get<RouteQuery>(queries[index]).to);
+        }
+
+        const auto routes {m_router.BuildRoutes(from, targets)};
+        for (size_t i {0}; i < group.size(); ++i) {
+            const auto& query {std::get<RouteQuery>(queries[group[i]])};
+            results[group[i]] = ToJSON(routes[i], query.request_id);
+        }
+    }
 }
 
 void RequestHandler::ProcessStatRequests(std::ostream& out)
 {
     std::vector<Query> queries {m_reader.GetQueries()};
 
-    json::Array results;
-    for (const auto& query : queries) {
-        results.emplace_back(std::visit(QueryVisitor
+    const bool has_route_queries {
+        std::any_of(queries.begin(), queries.end(), [](const Query& query) {
+            return std::holds_alternative<RouteQuery>(query)
+                   || std::holds_alternative<RouteMatrixQuery>(query)
+                   || std::holds_alternative<ReachableQuery>(query);
+        })
+    };
+    if (has_route_queries) {
+        EnsureRouter();
+    }
+
+    json::Array results(queries.size());
+    ProcessRouteQueries(queries, results);
+    for (size_t index {0}; index < queries.size(); ++index) {
+        if (std::holds_alternative<RouteQuery>(queries[index])) continue;
+        results[index] = std::visit(QueryVisitor
                           {m_transport_catalogue,
                            m_renderer,
-                           m_router}, query));
+                           m_router}, queries[index]);
     }
 
     if (!results.empty()) {
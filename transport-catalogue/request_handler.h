@@ -6,6 +6,8 @@
 #include "transport_router.h"
 
 #include <iostream>
+#include <optional>
+#include <string>
 
 class RequestHandler
 {
@@ -13,12 +15,19 @@ public:
     RequestHandler(std::istream& in);
     void ProcessBaseRequests();
     void ProcessStatRequests(std::ostream& out = std::cout);
-    void Serialize() const;
+    void Serialize();
     void Deserialize();
 
 private:
+    // Строит маршрутизатор или загружает его из базы, если это ещё не сделано
+    void EnsureRouter();
+
+    void ProcessRouteQueries(const std::vector<Query>& queries,
+                             json::Array& results) const;
+
     const json::Reader m_reader;
     TransportCatalogue m_transport_catalogue;
     MapRenderer m_renderer;
     transport::Router m_router;
+    std::optional<std::string> m_router_data;
 };
@@ -0,0 +1,56 @@
+#include "route_cache.h"
+
+#include <cstdint>
+
+namespace transport {
+
+RouteCache::RouteCache(size_t capacity)
+    : m_capacity {capacity}
+{
+    m_index.reserve(capacity);
+}
+
+std::optional<RouteCache::Value> RouteCache::Find(const Key& key) {
+    std::lock_guard lock {m_mutex};
+    const auto it {m_index.find(key)};
+    if (it == m_index.end()) {
+        ++m_stats.misses;
+        return std::nullopt;
+    }
+    ++m_stats.hits;
+    m_items.splice(m_items.begin(), m_items, it->second);
+    return it->second->second;
+}
+
+void RouteCache::Insert(const Key& key, Value value) {
+    if (m_capacity == 0) return;
+
+    std::lock_guard lock {m_mutex};
+    if (const auto it {m_index.find(key)}; it != m_index.end()) {
+        it->second->second = std::move(value);
+        m_items.splice(m_items.begin(), m_items, it->second);
+        return;
+    }
+    if (m_items.size() == m_capacity) {
+        m_index.erase(m_items.back().first);
+        m_items.pop_back();
+    }
+    m_items.emplace_front(key, std::move(value));
+    m_index.emplace(key, m_items.begin());
+}
+
+RouteCache::Stats RouteCache::GetStats() const {
+    std::lock_guard lock {m_mutex};
+    return m_stats;
+}
+
+size_t RouteCache::KeyHasher::operator() (const Key& key) const {
+    // Перемешивание битов упакованного ключа (финализатор splitmix64)
+    uint64_t hash {(static_cast<uint64_t>(key.first) << 32) | key.second};
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return static_cast<size_t>(hash);
+}
+
+} // namespace transport
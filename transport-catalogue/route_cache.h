@@ -0,0 +1,51 @@
+#pragma once
+
+#include "domain.h"
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace transport {
+
+// Потокобезопасный кэш готовых маршрутов с вытеснением давно не
+// использованных (LRU). Ключ — пара номеров остановок (откуда, куда).
+class RouteCache
+{
+public:
+    using Key = std::pair<StopId, StopId>;
+    // Пустой указатель означает, что маршрута нет
+    using Value = std::shared_ptr<const RouteInfo>;
+
+    struct Stats {
+        size_t hits {0};
+        size_t misses {0};
+    };
+
+    explicit RouteCache(size_t capacity);
+
+    std::optional<Value> Find(const Key& key);
+    void Insert(const Key& key, Value value);
+
+    Stats GetStats() const;
+
+private:
+    struct KeyHasher {
+        size_t operator() (const Key& key) const;
+    };
+
+    using Items = std::list<std::pair<Key, Value>>;
+
+    mutable std::mutex m_mutex;
+    const size_t m_capacity;
+    // Элементы от недавно использованных к давно не использованным
+    Items m_items;
+    std::unordered_map<Key, Items::iterator, KeyHasher> m_index;
+    Stats m_stats;
+};
+
+} // namespace transport
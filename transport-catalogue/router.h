@@ -1,118 +1,400 @@
 #pragma once
 
 #include "graph.h"
+#include "min_plus_kernel.h"
 
 #include <algorithm>
 #include <cassert>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <mutex>
+#include <numeric>
 #include <optional>
+#include <queue>
 #include <stdexcept>
-#include <unordered_map>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace graph {
 
-template <typename Weight>
-class Router {
-private:
-    using Graph = DirectedWeightedGraph<Weight>;
+namespace detail {
 
+// Многоразовый барьер для синхронизации потоков между шагами алгоритма
+class Barrier {
 public:
-    explicit Router(const Graph& graph);
+    explicit Barrier(size_t count)
+        : count_(count)
+    {}
+
+    void Wait() {
+        std::unique_lock lock(mutex_);
+        const size_t generation = generation_;
+        if (++waiting_ == count_) {
+            waiting_ = 0;
+            ++generation_;
+            condition_.notify_all();
+            return;
+        }
+        condition_.wait(lock, [this, generation] { return generation != generation_; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    const size_t count_;
+    size_t waiting_ = 0;
+    size_t generation_ = 0;
+};
+
+}  // namespace detail
 
+// Счётчики одного поиска пути, для сравнения движков
+struct SearchStats {
+    // Вершины, извлечённые из очереди с окончательным весом
+    size_t settled_vertex_count = 0;
+};
+
+// Общий интерфейс движков маршрутизации по DirectedWeightedGraph
+template <typename Weight>
+class RouterBase {
+public:
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    virtual ~RouterBase() = default;
+
+    virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+
+    // Маршруты из одной вершины в несколько. Движки, которые ищут пути
+    // из источника, переопределяют метод и обходятся одним поиском
+    virtual std::vector<std::optional<RouteInfo>>
+    BuildRoutes(VertexId from, const std::vector<VertexId>& to) const {
+        std::vector<std::optional<RouteInfo>> routes;
+        routes.reserve(to.size());
+        for (const VertexId target : to) {
+            routes.push_back(BuildRoute(from, target));
+        }
+        return routes;
+    }
+
+    // Только веса маршрутов из одной вершины в несколько, без самих путей
+    virtual std::vector<std::optional<Weight>>
+    BuildWeights(VertexId from, const std::vector<VertexId>& to) const {
+        std::vector<std::optional<Weight>> weights;
+        weights.reserve(to.size());
+        for (const auto& route : BuildRoutes(from, to)) {
+            weights.push_back(route ? std::optional<Weight>(route->weight) : std::nullopt);
+        }
+        return weights;
+    }
+
+    // Матрица весов маршрутов: строка на каждую вершину from
+    virtual std::vector<std::vector<std::optional<Weight>>>
+    BuildWeightMatrix(const std::vector<VertexId>& from, const std::vector<VertexId>& to) const {
+        std::vector<std::vector<std::optional<Weight>>> matrix;
+        matrix.reserve(from.size());
+        for (const VertexId origin : from) {
+            matrix.push_back(BuildWeights(origin, to));
+        }
+        return matrix;
+    }
+
+    // Объём предварительно вычисленных данных движка в байтах
+    virtual size_t GetIndexSize() const {
+        return 0;
+    }
 
+    // Сохраняет предварительно вычисленные данные движка, если они есть
+    virtual bool Serialise(proto::graph::Router&) const {
+        return true;
+    }
+};
+
+// Кратчайшие пути между всеми парами терминальных вершин (Флойд-Уоршелл).
+// Остальные вершины служат только промежуточными: таблица имеет размер
+// терминалов на терминалы. Путь между двумя терминалами, все внутренние
+// вершины которого нетерминальные, сохраняется как переход (hop) —
+// последовательность исходных рёбер. По умолчанию терминальны все вершины.
+template <typename Weight>
+class Router : public RouterBase<Weight> {
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
-    };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    explicit Router(const Graph& graph, size_t thread_count = 1);
+    Router(const Graph& graph, std::vector<VertexId> terminals, size_t thread_count = 1);
+    Router(const Graph& graph, const proto::graph::Router& proto_router);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::vector<std::optional<Weight>>
+    BuildWeights(VertexId from, const std::vector<VertexId>& to) const override;
+    size_t GetIndexSize() const override {
+        return weights_.size() * sizeof(Weight)
+               + prev_hops_.size() * sizeof(CompactId)
+               + hop_sources_.size() * sizeof(CompactId)
+               + hop_offsets_.size() * sizeof(size_t)
+               + hop_edges_.size() * sizeof(CompactId);
+    }
+
+    bool Serialise(proto::graph::Router& proto_router) const override;
+    bool Deserialise(const proto::graph::Router& proto_router);
+
+private:
+    // Таблица хранится одним непрерывным блоком по строкам:
+    // веса и последние переходы маршрутов лежат в двух параллельных массивах
+    using CompactId = uint32_t;
+    static constexpr CompactId NO_ID = std::numeric_limits<CompactId>::max();
+    static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::has_infinity
+                                          ? std::numeric_limits<Weight>::infinity()
+                                          : std::numeric_limits<Weight>::max();
+
+    size_t GetIndex(size_t from, size_t to) const {
+        return from * terminal_count_ + to;
+    }
+
+    void InitializeTerminals(std::vector<VertexId> terminals) {
+        if (terminals.size() >= NO_ID || graph_.GetEdgeIdBound() >= NO_ID) {
+            throw std::length_error("Graph is too large for the routes table");
+        }
+        terminals_ = std::move(terminals);
+        terminal_count_ = terminals_.size();
+        terminal_indices_.assign(graph_.GetVertexCount(), NO_ID);
+        for (size_t index = 0; index < terminal_count_; ++index) {
+            terminal_indices_.at(terminals_[index]) = static_cast<CompactId>(index);
+        }
+    }
 
+    // Из каждого терминала ищет кратчайшие пути до остальных терминалов,
+    // проходящие только через нетерминальные вершины, и заносит их в таблицу
     void InitializeRoutesInternalData(const Graph& graph) {
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
-            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                const auto& edge = graph.GetEdge(edge_id);
-                if (edge.weight < ZERO_WEIGHT) {
-                    throw std::domain_error("Edges' weights should be non-negative");
+        weights_.assign(terminal_count_ * terminal_count_, UNREACHABLE);
+        prev_hops_.assign(terminal_count_ * terminal_count_, NO_ID);
+        hop_offsets_.assign(1, 0);
+
+        std::vector<Weight> weights(graph.GetVertexCount(), UNREACHABLE);
+        std::vector<EdgeId> prev_edges(graph.GetVertexCount());
+        std::vector<VertexId> reached;
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+        for (size_t from = 0; from < terminal_count_; ++from) {
+            const VertexId source = terminals_[from];
+            weights_[GetIndex(from, from)] = ZERO_WEIGHT;
+            weights[source] = ZERO_WEIGHT;
+            reached.push_back(source);
+            queue.emplace(ZERO_WEIGHT, source);
+            while (!queue.empty()) {
+                const Weight weight = queue.top().first;
+                const VertexId vertex = queue.top().second;
+                queue.pop();
+                if (weight > weights[vertex]
+                        || (vertex != source && terminal_indices_[vertex] != NO_ID)) {
+                    continue;
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                graph.ForEachIncidentEdge(vertex, [&](EdgeId edge_id, const Edge<Weight>& edge) {
+                    if (edge.weight < ZERO_WEIGHT) {
+                        throw std::domain_error("Edges' weights should be non-negative");
+                    }
+                    const Weight candidate_weight = weight + edge.weight;
+                    if (candidate_weight < weights[edge.to]) {
+                        if (weights[edge.to] == UNREACHABLE) {
+                            reached.push_back(edge.to);
+                        }
+                        weights[edge.to] = candidate_weight;
+                        prev_edges[edge.to] = edge_id;
+                        queue.emplace(candidate_weight, edge.to);
+                    }
+                });
+            }
+
+            for (const VertexId vertex : reached) {
+                const CompactId to = terminal_indices_[vertex];
+                if (to != NO_ID && vertex != source) {
+                    weights_[GetIndex(from, to)] = weights[vertex];
+                    prev_hops_[GetIndex(from, to)] = AddHop(from, source, vertex, prev_edges);
                 }
+                weights[vertex] = UNREACHABLE;
             }
+            reached.clear();
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    CompactId AddHop(size_t from, VertexId source, VertexId target,
+                     const std::vector<EdgeId>& prev_edges) {
+        const size_t begin = hop_edges_.size();
+        for (VertexId vertex = target; vertex != source; vertex = graph_.GetEdge(prev_edges[vertex]).from) {
+            hop_edges_.push_back(static_cast<CompactId>(prev_edges[vertex]));
         }
+        std::reverse(hop_edges_.begin() + static_cast<std::ptrdiff_t>(begin), hop_edges_.end());
+        hop_offsets_.push_back(hop_edges_.size());
+        hop_sources_.push_back(static_cast<CompactId>(from));
+        if (hop_sources_.size() >= NO_ID) {
+            throw std::length_error("Too many hops for the routes table");
+        }
+        return static_cast<CompactId>(hop_sources_.size() - 1);
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+    void RelaxRoutesInternalDataThroughVertex(size_t vertex_through,
+                                              size_t from_begin, size_t from_end) {
+        const Weight* weights_through = &weights_[GetIndex(vertex_through, 0)];
+        const CompactId* prev_hops_through = &prev_hops_[GetIndex(vertex_through, 0)];
+        for (size_t vertex_from = from_begin; vertex_from < from_end; ++vertex_from) {
+            const Weight weight_from = weights_[GetIndex(vertex_from, vertex_through)];
+            if (weight_from == UNREACHABLE) {
+                continue;
+            }
+            const CompactId prev_hop_from = prev_hops_[GetIndex(vertex_from, vertex_through)];
+            Weight* weights_relaxing = &weights_[GetIndex(vertex_from, 0)];
+            CompactId* prev_hops_relaxing = &prev_hops_[GetIndex(vertex_from, 0)];
+            if constexpr (std::is_same_v<Weight, double>) {
+                // Последний переход пути через вершину отсутствует только при vertex_to,
+                // равной vertex_through, а в этом случае строгого улучшения не бывает.
+                // Поэтому векторное ядро всегда берёт переход из строки vertex_through.
+                detail::RelaxRowMinPlus(weight_from, weights_through, prev_hops_through,
+                                        weights_relaxing, prev_hops_relaxing, terminal_count_);
+            } else {
+                for (size_t vertex_to = 0; vertex_to < terminal_count_; ++vertex_to) {
+                    if (weights_through[vertex_to] == UNREACHABLE) {
+                        continue;
+                    }
+                    const Weight candidate_weight = weight_from + weights_through[vertex_to];
+                    if (candidate_weight < weights_relaxing[vertex_to]) {
+                        weights_relaxing[vertex_to] = candidate_weight;
+                        prev_hops_relaxing[vertex_to] = prev_hops_through[vertex_to] != NO_ID
+                                                         ? prev_hops_through[vertex_to]
+                                                         : prev_hop_from;
                     }
                 }
             }
         }
     }
 
+    // Строки таблицы делятся между потоками на равные полосы.
+    // Релаксация через вершину k не меняет ни строку, ни столбец k
+    // (веса неотрицательны, а улучшение строгое), поэтому полосы на одном шаге
+    // независимы, и результат побитово совпадает с однопоточным.
+    // Потоки синхронизируются барьером после каждого шага.
+    void RelaxRoutesInternalData(size_t thread_count) {
+        thread_count = std::clamp<size_t>(thread_count, 1, std::max<size_t>(terminal_count_, 1));
+        if (thread_count == 1) {
+            for (size_t vertex_through = 0; vertex_through < terminal_count_; ++vertex_through) {
+                RelaxRoutesInternalDataThroughVertex(vertex_through, 0, terminal_count_);
+            }
+            return;
+        }
+
+        detail::Barrier barrier(thread_count);
+        auto relax_stripe = [this, &barrier, thread_count](size_t stripe) {
+            const size_t from_begin = terminal_count_ * stripe / thread_count;
+            const size_t from_end = terminal_count_ * (stripe + 1) / thread_count;
+            for (size_t vertex_through = 0; vertex_through < terminal_count_; ++vertex_through) {
+                RelaxRoutesInternalDataThroughVertex(vertex_through, from_begin, from_end);
+                barrier.Wait();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count - 1);
+        for (size_t stripe = 1; stripe < thread_count; ++stripe) {
+            threads.emplace_back(relax_stripe, stripe);
+        }
+        relax_stripe(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
-    RoutesInternalData routes_internal_data_;
+    size_t terminal_count_ = 0;
+    std::vector<VertexId> terminals_;
+    std::vector<CompactId> terminal_indices_;
+    std::vector<Weight> weights_;
+    std::vector<CompactId> prev_hops_;
+    std::vector<CompactId> hop_sources_;
+    std::vector<size_t> hop_offsets_;
+    std::vector<CompactId> hop_edges_;
 };
 
 template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+Router<Weight>::Router(const Graph& graph, size_t thread_count)
+    : Router(graph, [&graph] {
+                 std::vector<VertexId> terminals(graph.GetVertexCount());
+                 std::iota(terminals.begin(), terminals.end(), VertexId{0});
+                 return terminals;
+             }(), thread_count)
+{
+}
+
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, std::vector<VertexId> terminals, size_t thread_count)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
 {
+    InitializeTerminals(std::move(terminals));
     InitializeRoutesInternalData(graph);
-
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
-    }
+    RelaxRoutesInternalData(thread_count);
 }
 
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo>
 Router<Weight>::BuildRoute(VertexId from, VertexId to) const
 {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    const CompactId terminal_from = terminal_indices_.at(from);
+    const CompactId terminal_to = terminal_indices_.at(to);
+    if (terminal_from == NO_ID || terminal_to == NO_ID) {
+        throw std::out_of_range("Routes are stored only between terminal vertices");
+    }
+    const size_t index = GetIndex(terminal_from, terminal_to);
+    if (weights_[index] == UNREACHABLE) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
+    const Weight weight = weights_[index];
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    // Кратчайший путь проходит каждый терминал не больше одного раза;
+    // более длинная цепочка переходов возможна только в испорченной таблице
+    size_t hop_count = 0;
+    for (CompactId hop = prev_hops_[index];
+         hop != NO_ID;
+         hop = prev_hops_[GetIndex(terminal_from, hop_sources_[hop])])
     {
-        edges.push_back(*edge_id);
+        if (++hop_count > terminal_count_) {
+            throw std::logic_error("Routes table contains a cycle");
+        }
+        for (size_t position = hop_offsets_[hop + 1]; position > hop_offsets_[hop]; --position) {
+            edges.push_back(hop_edges_[position - 1]);
+        }
     }
     std::reverse(edges.begin(), edges.end());
 
     return RouteInfo{weight, std::move(edges)};
 }
 
+template <typename Weight>
+std::vector<std::optional<Weight>>
+Router<Weight>::BuildWeights(VertexId from, const std::vector<VertexId>& to) const
+{
+    const CompactId terminal_from = terminal_indices_.at(from);
+    std::vector<std::optional<Weight>> weights;
+    weights.reserve(to.size());
+    for (const VertexId target : to) {
+        const CompactId terminal_to = terminal_indices_.at(target);
+        if (terminal_from == NO_ID || terminal_to == NO_ID) {
+            throw std::out_of_range("Routes are stored only between terminal vertices");
+        }
+        const Weight weight = weights_[GetIndex(terminal_from, terminal_to)];
+        weights.push_back(weight == UNREACHABLE ? std::nullopt : std::optional<Weight>(weight));
+    }
+    return weights;
+}
+
 }  // namespace graph
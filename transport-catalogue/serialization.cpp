@@ -22,12 +22,18 @@ const proto::TransportDatabase& TransportDatabase::GetData() const {
     return m_proto_database;
 }
 
-void RequestHandler::Serialize() const
+void RequestHandler::Serialize()
 {
+    EnsureRouter();
+
     TransportDatabase database;
     m_transport_catalogue.Serialize(*database.GetData().mutable_catalogue());
     m_renderer.Serialize(*database.GetData().mutable_renderer());
-    m_router.Serialize(*database.GetData().mutable_router());
+
+    proto::transport::Router proto_router;
+    m_router.Serialize(proto_router);
+    proto_router.SerializeToString(database.GetData().mutable_router());
+
     database.SaveTo(m_reader.GetSerializationSettings().file_name);
 }
 
@@ -37,32 +43,45 @@ void RequestHandler::Deserialize()
     database.LoadFrom(m_reader.GetSerializationSettings().file_name);
     m_transport_catalogue.Deserialize(database.GetData().catalogue());
     m_renderer.Deserialize(database.GetData().renderer());
-    m_router.Deserialize(database.GetData().router());
+    // Маршрутизатор восстанавливается только при первом запросе маршрута
+    m_router_data = std::move(*database.GetData().mutable_router());
 }
 
-bool TransportCatalogue::Serialize(proto::TransportCatalogue& proto_catalogue) const
+void RequestHandler::EnsureRouter()
 {
-    std::unordered_map<std::string_view, size_t> stops_to_id;
-    std::unordered_map<std::string_view, size_t> buses_to_id;
+    if (m_router.IsReady()) return;
+
+    if (!m_router_data) {
+        m_router.BuildGraph();
+        return;
+    }
+
+    proto::transport::Router proto_router;
+    proto_router.ParseFromString(*m_router_data);
+    m_router_data.reset();
+    // Настройки маршрутизации в запросе применяются к графу из базы
+    m_router.Deserialize(proto_router, m_reader.HasRoutingSettings()
+                                       ? std::make_optional(m_reader.GetRoutingSettings())
+                                       : std::nullopt);
+}
 
-    size_t stop_id {0};
+bool TransportCatalogue::Serialize(proto::TransportCatalogue& proto_catalogue) const
+{
+    // Номера в базе совпадают с StopId и BusId каталога
     for (const auto& stop : m_dqstops) {
         auto proto_stop = proto_catalogue.add_stops();
-        stops_to_id.emplace(stop.name, stop_id);
-        proto_stop->set_id(stop_id++);
+        proto_stop->set_id(stop.id);
         proto_stop->set_name(stop.name);
         proto_stop->set_lat(stop.coord.lat);
         proto_stop->set_lng(stop.coord.lng);
     }
 
-    size_t bus_id {0};
     for (const auto& bus : m_dqbuses) {
         auto proto_bus = proto_catalogue.add_buses();
-        buses_to_id.emplace(bus.name, bus_id);
-        proto_bus->set_id(bus_id++);
+        proto_bus->set_id(bus.id);
         proto_bus->set_name(bus.name);
         for (const auto& stop : bus.stops) {
-            proto_bus->add_stops(stops_to_id.at(stop->name));
+            proto_bus->add_stops(stop->id);
         }
         proto_bus->set_is_roundtrip(bus.is_roundtrip);
         proto_bus->set_num_unique(bus.num_unique);
@@ -70,41 +89,43 @@ bool TransportCatalogue::Serialize(proto::TransportCatalogue& proto_catalogue) c
         proto_bus->set_route_length(bus.route_length);
     }
 
-    for (const auto& [pair_stop, distance] : m_stops_distance) {
+    m_stops_distance.ForEachExplicit([&proto_catalogue](StopId from, StopId to, int distance) {
         auto proto_distance = proto_catalogue.add_distances();
-        proto_distance->set_stop_first(stops_to_id.at(pair_stop.first));
-        proto_distance->set_stop_second(stops_to_id.at(pair_stop.second));
+        proto_distance->set_stop_first(from);
+        proto_distance->set_stop_second(to);
         proto_distance->set_value(distance);
-    }
+    });
 
-    for (const auto& [stop, set_buses] : m_stop_to_buses) {
-        auto proto_stop_to_buses = proto_catalogue.add_stop_to_buses();
-        proto_stop_to_buses->set_stop_id(stops_to_id.at(stop));
-        for(const auto& bus_name : set_buses) {
-            proto_stop_to_buses->add_buses_id(buses_to_id.at(bus_name));
-        }
-    }
+    m_stop_names.Serialize(*proto_catalogue.mutable_stop_names());
+    m_bus_names.Serialize(*proto_catalogue.mutable_bus_names());
 
     return true;
 }
 
 bool TransportCatalogue::Deserialize(const proto::TransportCatalogue& proto_catalogue)
 {
-    std::unordered_map<size_t, StopPtrConst> id_to_stop;
-    std::unordered_map<size_t, BusPtrConst> id_to_bus;
+    const auto to_stop_id = [&proto_catalogue](uint64_t id) {
+        if (id >= static_cast<uint64_t>(proto_catalogue.stops_size())) {
+            throw std::out_of_range("Stop id is out of range");
+        }
+        return static_cast<StopId>(id);
+    };
 
     for (const auto& proto_stop : proto_catalogue.stops()) {
-        StopPtrConst stop_ptr {
-            EmplaceStop({proto_stop.name(),
-                        {proto_stop.lat(), proto_stop.lng()}
-                        })
-        };
-        id_to_stop.emplace(proto_stop.id(), stop_ptr);
+        EmplaceStop({proto_stop.name(),
+                    {proto_stop.lat(), proto_stop.lng()}
+                    });
+    }
+    // Индекс названий из базы используется как есть; база без него
+    // или с индексом под другой набор названий индексируется заново
+    if (!m_stop_names.Deserialize(proto_catalogue.stop_names(), m_dqstops.size())) {
+        IndexStopNames();
     }
 
+    m_stops_distance.Reserve(static_cast<size_t>(proto_catalogue.distances_size()));
     for (const auto& proto_distance : proto_catalogue.distances()) {
-        SetDistance(id_to_stop.at(proto_distance.stop_first())->name,
-                    id_to_stop.at(proto_distance.stop_second())->name,
+        SetDistance(to_stop_id(proto_distance.stop_first()),
+                    to_stop_id(proto_distance.stop_second()),
                     proto_distance.value()
                     );
     }
@@ -114,34 +135,56 @@ bool TransportCatalogue::Deserialize(const proto::TransportCatalogue& proto_cata
         stops_ptrs.reserve(proto_bus.stops_size());
 
         for (const auto& stop_id : proto_bus.stops()) {
-            stops_ptrs.emplace_back(id_to_stop.at(stop_id));
+            stops_ptrs.emplace_back(&m_dqstops[to_stop_id(stop_id)]);
         }
 
-        BusPtrConst bus_ptr {
-            EmplaceBus({std::string(proto_bus.name()),
-                        std::move(stops_ptrs),
-                        proto_bus.num_unique(),
-                        proto_bus.route_length(),
-                        proto_bus.is_roundtrip()
-                       })
-        };
-        id_to_bus.emplace(proto_bus.id(), bus_ptr);
+        EmplaceBus({std::string(proto_bus.name()),
+                    std::move(stops_ptrs),
+                    proto_bus.num_unique(),
+                    proto_bus.route_length(),
+                    proto_bus.is_roundtrip()
+                   });
     }
 
-    for (const auto& proto_stop_to_buses : proto_catalogue.stop_to_buses()) {
-        std::set<std::string_view> buses_set;
-        for (const auto& bus_id : proto_stop_to_buses.buses_id()) {
-            buses_set.insert(id_to_bus.at(bus_id)->name);
-        }
-        m_stop_to_buses.emplace(
-                    id_to_stop.at(proto_stop_to_buses.stop_id())->name,
-                    std::move(buses_set)
-                    );
+    if (!m_bus_names.Deserialize(proto_catalogue.bus_names(), m_dqbuses.size())) {
+        IndexBusNames();
     }
+    // Индекс автобусов остановок строится по маршрутам, а не хранится в базе
+    IndexStopBuses();
 
     return true;
 }
 
+bool NameIndex::Serialize(proto::NameIndex& proto_index) const
+{
+    proto_index.set_seed(m_seed);
+    proto_index.mutable_displacements()->Add(m_displacements.begin(), m_displacements.end());
+    proto_index.mutable_ids()->Add(m_ids.begin(), m_ids.end());
+    return true;
+}
+
+bool NameIndex::Deserialize(const proto::NameIndex& proto_index, size_t name_count)
+{
+    const auto& ids {proto_index.ids()};
+    const auto& displacements {proto_index.displacements()};
+    // Повторяющиеся названия в индекс не попадают, поэтому ячеек
+    // может быть меньше, чем названий, но не больше
+    if (static_cast<size_t>(ids.size()) > name_count
+        || (ids.empty() && name_count > 0)
+        || (ids.empty() != displacements.empty())) {
+        return false;
+    }
+    for (const uint32_t id : ids) {
+        if (id >= name_count) {
+            return false;
+        }
+    }
+    m_seed = proto_index.seed();
+    m_displacements.assign(displacements.begin(), displacements.end());
+    m_ids.assign(ids.begin(), ids.end());
+    return true;
+}
+
 bool MapRenderer::Serialize(proto::MapRenderer &proto_renderer) const {
 
     auto fill_proto_color = [](proto::svg::Color* proto_color,
@@ -246,65 +289,108 @@ bool Router::Serialize(proto::transport::Router& proto_router) const {
     auto proto_settings = proto_router.mutable_settings();
     proto_settings->set_bus_wait_time(m_settings.bus_wait_time);
     proto_settings->set_bus_velocity(m_settings.bus_velocity);
+    proto_settings->set_router_type(
+                static_cast<proto::transport::RouterType>(m_settings.router_type));
+    proto_settings->set_thread_count(static_cast<uint32_t>(m_settings.thread_count));
+    proto_settings->set_cache_capacity(m_settings.cache_capacity);
+
+    if (!m_graph) {
+        return true;
+    }
 
     auto proto_graph = proto_router.mutable_graph();
     m_graph->Serialise(*proto_graph);
+    m_router->Serialise(*proto_router.mutable_router());
 
-    auto proto_vertex_to_name = proto_router.mutable_vertex_to_name();
-    for(const auto& [id, name] : m_vertex_to_name) {
-        (*proto_vertex_to_name)[id] = std::string(name);
-    }
+    proto_router.mutable_vertex_stops()->Add(m_vertex_to_stop.begin(), m_vertex_to_stop.end());
 
-    auto proto_name_to_vertex_wait = proto_router.mutable_name_to_vertex_wait();
-    for(const auto& [name, id] : m_name_to_vertex_wait) {
-        (*proto_name_to_vertex_wait)[std::string(name)] = id;
+    proto_router.mutable_edges()->Reserve(static_cast<int>(m_edge_to_data.size()));
+    for (const auto& data : m_edge_to_data) {
+        auto proto_data = proto_router.add_edges();
+        proto_data->set_bus_id(static_cast<uint32_t>(data.bus));
+        proto_data->set_span_count(data.span_count);
+        proto_data->set_is_wait(data.is_wait);
     }
 
-    auto proto_name_to_vertex_go = proto_router.mutable_name_to_vertex_go();
-    for(const auto& [name, id] : m_name_to_vertex_go) {
-        (*proto_name_to_vertex_go)[std::string(name)] = id;
-    }
-
-    auto proto_edge_to_data = proto_router.mutable_edge_to_data();
-    for(const auto& [edge, data] : m_edge_to_data) {
-        auto& proto_data = (*proto_edge_to_data)[edge] = {};
-        proto_data.set_bus(std::string(data.bus));
-        proto_data.set_span_count(data.span_count);
-        proto_data.set_is_wait(data.is_wait);
-    }
+    proto_router.mutable_line_bus_ids()->Add(m_line_to_bus.begin(), m_line_to_bus.end());
+    proto_router.mutable_line_distances()->Add(m_line_distances.begin(), m_line_distances.end());
 
     return true;
 }
 
-bool Router::Deserialize(const proto::transport::Router &proto_router) {
+bool Router::Deserialize(const proto::transport::Router &proto_router,
+                         const std::optional<RoutingSettings>& settings) {
 
     m_settings.bus_wait_time = proto_router.settings().bus_wait_time();
     m_settings.bus_velocity = proto_router.settings().bus_velocity();
+    m_settings.router_type = static_cast<RouterType>(proto_router.settings().router_type());
+    m_settings.thread_count = proto_router.settings().thread_count();
+    m_settings.cache_capacity = proto_router.settings().cache_capacity();
+    MakeCache();
+    const bool is_reweighted {settings && ApplyWeightSettings(*settings)};
+
+    if (m_settings.router_type == RouterType::Raptor) {
+        m_raptor = std::make_unique<RaptorRouter>(m_transport_catalogue, m_settings);
+        return true;
+    }
 
     const auto nodes_count {m_transport_catalogue.GetStops().size()};
+    const auto buses_count {m_transport_catalogue.GetBuses().size()};
+    const auto& proto_graph {proto_router.graph()};
+    const auto& vertex_stops {proto_router.vertex_stops()};
+    const auto& line_buses {proto_router.line_bus_ids()};
+    const auto& edges {proto_router.edges()};
     m_graph = std::make_unique<graph::DirectedWeightedGraph<double>>(2 * nodes_count);
-    m_graph->Deserialise(proto_router.graph());
-    m_router = std::make_unique<graph::Router<double>>(*m_graph);
-
-    for(const auto& [vertex, name] : proto_router.vertex_to_name()) {
-        m_vertex_to_name[vertex] = m_transport_catalogue.GetStop(name)->name;
+    // Номера остановок, автобусов и рёбер из базы используются как индексы
+    if (!m_graph->Deserialise(proto_graph)
+            || static_cast<size_t>(vertex_stops.size()) != 2 * nodes_count
+            || std::any_of(vertex_stops.begin(), vertex_stops.end(), [nodes_count](uint32_t stop_id) {
+                   return stop_id >= nodes_count;
+               })
+            || edges.size() != proto_graph.edge_targets_size()
+            || std::any_of(edges.begin(), edges.end(), [buses_count](const auto& data) {
+                   return !data.is_wait() && data.bus_id() >= buses_count;
+               })
+            || line_buses.size() + 1 != proto_graph.line_offsets_size()
+            || std::any_of(line_buses.begin(), line_buses.end(), [buses_count](uint32_t bus_id) {
+                   return bus_id >= buses_count;
+               })
+            || proto_router.line_distances_size() != proto_graph.line_from_size()) {
+        throw std::invalid_argument("Route graph does not match the catalogue");
     }
 
-    for(const auto& [name, vertex] : proto_router.name_to_vertex_wait()) {
-        m_name_to_vertex_wait[m_transport_catalogue.GetStop(name)->name] = vertex;
+    m_vertex_to_stop.assign(proto_router.vertex_stops().begin(), proto_router.vertex_stops().end());
+    IndexStopVertices();
+
+    m_edge_to_data.reserve(static_cast<size_t>(proto_router.edges_size()));
+    for (const auto& data : proto_router.edges()) {
+        m_edge_to_data.push_back({data.bus_id(), data.span_count(), data.is_wait()});
     }
 
-    for(const auto& [name, vertex] : proto_router.name_to_vertex_go()) {
-        m_name_to_vertex_go[m_transport_catalogue.GetStop(name)->name] = vertex;
+    m_line_to_bus.assign(proto_router.line_bus_ids().begin(), proto_router.line_bus_ids().end());
+    m_line_distances.assign(proto_router.line_distances().begin(), proto_router.line_distances().end());
+
+    if (is_reweighted) {
+        // Сохранённые структуры поиска посчитаны для прежних весов
+        ReweightGraph();
+        m_router = MakeRouter();
+        return true;
     }
 
-    for(const auto& [edge, data] : proto_router.edge_to_data()) {
-        m_edge_to_data[edge] =
-                EdgeData {
-                    m_transport_catalogue.GetBus(data.bus())->name,
-                    data.span_count(),
-                    data.is_wait()
-                };
+    // Таблица кратчайших путей, иерархия сжатий и метки хабов уже посчитаны при make_base
+    switch (m_settings.router_type) {
+    case RouterType::AllPairs:
+        m_router = std::make_unique<graph::Router<double>>(*m_graph, proto_router.router());
+        break;
+    case RouterType::ContractionHierarchy:
+        m_router = std::make_unique<graph::ContractionHierarchyRouter<double>>(*m_graph,
+                                                                               proto_router.router());
+        break;
+    case RouterType::HubLabels:
+        m_router = std::make_unique<graph::HubLabelsRouter<double>>(*m_graph, proto_router.router());
+        break;
+    default:
+        m_router = MakeRouter();
     }
 
     return true;
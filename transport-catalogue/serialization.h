@@ -1,8 +1,15 @@
 #pragma once
 
 #include "graph.h"
+#include "hub_labels.h"
+#include "contraction_hierarchy.h"
+#include "router.h"
 #include <transport_catalogue.pb.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
 #include <string>
 #include <fstream>
 
@@ -22,35 +29,296 @@ private:
 };
 
 namespace graph {
+
+namespace detail {
+
+// Смещения CSR начинаются с нуля, не убывают и заканчиваются числом элементов
+template <typename Offsets>
+bool IsValidOffsets(const Offsets& offsets, size_t count) {
+    return !offsets.empty()
+           && offsets[0] == 0
+           && std::is_sorted(offsets.begin(), offsets.end())
+           && offsets[offsets.size() - 1] == count;
+}
+
+}  // namespace detail
+
 template <typename Weight>
 bool DirectedWeightedGraph<Weight>::Serialise(proto::graph::Graph &proto_graph) const {
+    if (!IsFrozen()) {
+        return false;
+    }
+
+    proto_graph.mutable_offsets()->Add(offsets_.begin(), offsets_.end());
+    proto_graph.mutable_edge_targets()->Reserve(static_cast<int>(edges_.size()));
+    proto_graph.mutable_edge_weights()->Reserve(static_cast<int>(edges_.size()));
+    for (const auto& edge : edges_) {
+        proto_graph.add_edge_targets(edge.to);
+        proto_graph.add_edge_weights(edge.weight);
+    }
+
+    proto_graph.mutable_line_offsets()->Add(line_offsets_.begin(), line_offsets_.end());
+    proto_graph.mutable_line_from()->Add(line_from_.begin(), line_from_.end());
+    proto_graph.mutable_line_to()->Add(line_to_.begin(), line_to_.end());
+    proto_graph.mutable_line_prefix_weights()->Add(line_prefix_weights_.begin(), line_prefix_weights_.end());
+    return true;
+}
 
-    for(const auto& edge : edges_) {
-        auto proto_edge = proto_graph.add_edges();
-        proto_edge->set_from(edge.from);
-        proto_edge->set_to(edge.to);
-        proto_edge->set_weight(edge.weight);
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::Deserialise(const proto::graph::Graph &proto_graph)
+{
+    const auto is_vertices = [this](const auto& vertices) {
+        return std::all_of(vertices.begin(), vertices.end(), [this](uint64_t vertex) {
+            return vertex < vertex_count_;
+        });
+    };
+
+    const size_t edge_count = static_cast<size_t>(proto_graph.edge_targets_size());
+    const size_t position_count = static_cast<size_t>(proto_graph.line_from_size());
+    if (static_cast<size_t>(proto_graph.offsets_size()) != vertex_count_ + 1
+            || static_cast<size_t>(proto_graph.edge_weights_size()) != edge_count
+            || static_cast<size_t>(proto_graph.line_to_size()) != position_count
+            || static_cast<size_t>(proto_graph.line_prefix_weights_size()) != position_count
+            || !detail::IsValidOffsets(proto_graph.offsets(), edge_count)
+            || !detail::IsValidOffsets(proto_graph.line_offsets(), position_count)
+            || !is_vertices(proto_graph.edge_targets())
+            || !is_vertices(proto_graph.line_from())
+            || !is_vertices(proto_graph.line_to())) {
+        return false;
     }
 
-    for(const auto& list : incidence_lists_) {
-        auto proto_list = proto_graph.add_incidence_lists();
-        for(const auto& edge : list) {
-            proto_list->add_edges_id(edge);
+    offsets_.assign(proto_graph.offsets().begin(), proto_graph.offsets().end());
+    edges_.clear();
+    edges_.reserve(edge_count);
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        for (EdgeId edge_id = offsets_[vertex]; edge_id < offsets_[vertex + 1]; ++edge_id) {
+            const int index = static_cast<int>(edge_id);
+            edges_.push_back({vertex,
+                              proto_graph.edge_targets(index),
+                              proto_graph.edge_weights(index)});
         }
     }
+
+    line_offsets_.assign(proto_graph.line_offsets().begin(), proto_graph.line_offsets().end());
+    line_from_.assign(proto_graph.line_from().begin(), proto_graph.line_from().end());
+    line_to_.assign(proto_graph.line_to().begin(), proto_graph.line_to().end());
+    line_prefix_weights_.assign(proto_graph.line_prefix_weights().begin(),
+                                proto_graph.line_prefix_weights().end());
+    IndexIncomingEdges();
+    IndexLines();
     return true;
 }
 
 template <typename Weight>
-bool DirectedWeightedGraph<Weight>::Deserialise(const proto::graph::Graph &proto_graph)
+Router<Weight>::Router(const Graph& graph, const proto::graph::Router& proto_router)
+    : graph_(graph)
 {
-    for (const auto& proto_edge : proto_graph.edges()) {
-        AddEdge({
-                    proto_edge.from(),
-                    proto_edge.to(),
-                    proto_edge.weight()
-                });
+    Deserialise(proto_router);
+}
+
+template <typename Weight>
+bool Router<Weight>::Serialise(proto::graph::Router& proto_router) const {
+    proto_router.mutable_weights()->Add(weights_.begin(), weights_.end());
+
+    auto proto_prev_hops = proto_router.mutable_prev_hops();
+    proto_prev_hops->Reserve(static_cast<int>(prev_hops_.size()));
+    for (const CompactId hop : prev_hops_) {
+        proto_prev_hops->AddAlreadyReserved(hop == NO_ID ? 0 : uint64_t{hop} + 1);
+    }
+
+    proto_router.mutable_terminals()->Add(terminals_.begin(), terminals_.end());
+    proto_router.mutable_hop_sources()->Add(hop_sources_.begin(), hop_sources_.end());
+    proto_router.mutable_hop_offsets()->Add(hop_offsets_.begin(), hop_offsets_.end());
+    proto_router.mutable_hop_edges()->Add(hop_edges_.begin(), hop_edges_.end());
+    return true;
+}
+
+template <typename Weight>
+bool Router<Weight>::Deserialise(const proto::graph::Router& proto_router) {
+    const auto& terminals = proto_router.terminals();
+    const auto& prev_hops = proto_router.prev_hops();
+    const auto& hop_sources = proto_router.hop_sources();
+    const auto& hop_edges = proto_router.hop_edges();
+    const size_t terminal_count = static_cast<size_t>(terminals.size());
+    const size_t hop_count = static_cast<size_t>(hop_sources.size());
+    // BuildRoute идёт по переходам без проверок, поэтому каждый номер
+    // терминала, перехода и ребра из базы проверяется заранее
+    if (std::any_of(terminals.begin(), terminals.end(), [this](uint64_t vertex) {
+            return vertex >= graph_.GetVertexCount();
+        })
+            || static_cast<size_t>(proto_router.weights_size()) != terminal_count * terminal_count
+            || prev_hops.size() != proto_router.weights_size()
+            || std::any_of(prev_hops.begin(), prev_hops.end(), [hop_count](uint64_t hop) {
+                   return hop > hop_count;
+               })
+            || std::any_of(hop_sources.begin(), hop_sources.end(), [terminal_count](uint64_t source) {
+                   return source >= terminal_count;
+               })
+            || static_cast<size_t>(proto_router.hop_offsets_size()) != hop_count + 1
+            || !detail::IsValidOffsets(proto_router.hop_offsets(), static_cast<size_t>(hop_edges.size()))
+            || std::any_of(hop_edges.begin(), hop_edges.end(), [this](uint64_t edge_id) {
+                   return !graph_.HasEdge(edge_id);
+               })) {
+        throw std::invalid_argument("Routes table does not match the graph");
     }
+
+    InitializeTerminals({terminals.begin(), terminals.end()});
+    weights_.assign(proto_router.weights().begin(), proto_router.weights().end());
+
+    prev_hops_.clear();
+    prev_hops_.reserve(terminal_count_ * terminal_count_);
+    for (const uint64_t hop : prev_hops) {
+        prev_hops_.push_back(hop == 0 ? NO_ID : static_cast<CompactId>(hop - 1));
+    }
+
+    hop_sources_.assign(hop_sources.begin(), hop_sources.end());
+    hop_offsets_.assign(proto_router.hop_offsets().begin(), proto_router.hop_offsets().end());
+    hop_edges_.assign(hop_edges.begin(), hop_edges.end());
+    return true;
+}
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph,
+                                                               const proto::graph::Router& proto_router)
+    : graph_(graph)
+{
+    Deserialise(proto_router);
+}
+
+template <typename Weight>
+bool ContractionHierarchyRouter<Weight>::Serialise(proto::graph::Router& proto_router) const {
+    auto& proto_hierarchy = *proto_router.mutable_hierarchy();
+    proto_hierarchy.mutable_ranks()->Add(ranks_.begin(), ranks_.end());
+    for (const Shortcut& shortcut : shortcuts_) {
+        proto_hierarchy.add_shortcut_from(shortcut.from);
+        proto_hierarchy.add_shortcut_to(shortcut.to);
+        proto_hierarchy.add_shortcut_weights(shortcut.weight);
+        proto_hierarchy.add_shortcut_first(shortcut.first);
+        proto_hierarchy.add_shortcut_second(shortcut.second);
+    }
+    return true;
+}
+
+template <typename Weight>
+bool ContractionHierarchyRouter<Weight>::Deserialise(const proto::graph::Router& proto_router) {
+    const auto& proto_hierarchy = proto_router.hierarchy();
+    const size_t vertex_count = graph_.GetVertexCount();
+    const int shortcut_count = proto_hierarchy.shortcut_from_size();
+    if (static_cast<size_t>(proto_hierarchy.ranks_size()) != vertex_count
+            || proto_hierarchy.shortcut_to_size() != shortcut_count
+            || proto_hierarchy.shortcut_weights_size() != shortcut_count
+            || proto_hierarchy.shortcut_first_size() != shortcut_count
+            || proto_hierarchy.shortcut_second_size() != shortcut_count) {
+        throw std::invalid_argument("Contraction hierarchy does not match the graph");
+    }
+
+    // Ранги — перестановка вершин
+    std::vector<bool> is_rank_used(vertex_count, false);
+    for (const uint32_t rank : proto_hierarchy.ranks()) {
+        if (rank >= vertex_count || is_rank_used[rank]) {
+            throw std::invalid_argument("Contraction hierarchy does not match the graph");
+        }
+        is_rank_used[rank] = true;
+    }
+    // Ярлык заменяет рёбра графа или ярлыки, добавленные раньше него,
+    // поэтому распаковка ярлыков не зацикливается
+    const EdgeId edge_id_bound = graph_.GetEdgeIdBound();
+    for (int i = 0; i < shortcut_count; ++i) {
+        const auto is_part = [this, edge_id_bound, i](uint64_t edge_id) {
+            return graph_.HasEdge(edge_id)
+                   || (edge_id >= edge_id_bound && edge_id - edge_id_bound < static_cast<uint64_t>(i));
+        };
+        if (proto_hierarchy.shortcut_from(i) >= vertex_count
+                || proto_hierarchy.shortcut_to(i) >= vertex_count
+                || !is_part(proto_hierarchy.shortcut_first(i))
+                || !is_part(proto_hierarchy.shortcut_second(i))) {
+            throw std::invalid_argument("Contraction hierarchy does not match the graph");
+        }
+    }
+
+    ranks_.assign(proto_hierarchy.ranks().begin(), proto_hierarchy.ranks().end());
+    shortcuts_.clear();
+    shortcuts_.reserve(static_cast<size_t>(shortcut_count));
+    for (int i = 0; i < shortcut_count; ++i) {
+        shortcuts_.push_back({proto_hierarchy.shortcut_from(i),
+                              proto_hierarchy.shortcut_to(i),
+                              proto_hierarchy.shortcut_weights(i),
+                              proto_hierarchy.shortcut_first(i),
+                              proto_hierarchy.shortcut_second(i)});
+    }
+    BuildSearchGraphs();
+    return true;
+}
+
+template <typename Weight>
+HubLabelsRouter<Weight>::HubLabelsRouter(const Graph& graph, const proto::graph::Router& proto_router)
+    : graph_(graph)
+{
+    Deserialise(proto_router);
+}
+
+template <typename Weight>
+bool HubLabelsRouter<Weight>::Serialise(proto::graph::Router& proto_router) const {
+    auto& proto_labels = *proto_router.mutable_labels();
+    const auto serialise_edges = [](const std::vector<CompactId>& edges, auto* proto_edges) {
+        proto_edges->Reserve(static_cast<int>(edges.size()));
+        for (const CompactId edge : edges) {
+            proto_edges->AddAlreadyReserved(edge == NO_ID ? 0 : uint64_t{edge} + 1);
+        }
+    };
+
+    proto_labels.mutable_forward_offsets()->Add(forward_labels_.offsets.begin(), forward_labels_.offsets.end());
+    proto_labels.mutable_forward_hubs()->Add(forward_labels_.hubs.begin(), forward_labels_.hubs.end());
+    proto_labels.mutable_forward_weights()->Add(forward_labels_.weights.begin(), forward_labels_.weights.end());
+    serialise_edges(forward_labels_.edges, proto_labels.mutable_forward_edges());
+
+    proto_labels.mutable_backward_offsets()->Add(backward_labels_.offsets.begin(), backward_labels_.offsets.end());
+    proto_labels.mutable_backward_hubs()->Add(backward_labels_.hubs.begin(), backward_labels_.hubs.end());
+    proto_labels.mutable_backward_weights()->Add(backward_labels_.weights.begin(), backward_labels_.weights.end());
+    serialise_edges(backward_labels_.edges, proto_labels.mutable_backward_edges());
+    return true;
+}
+
+template <typename Weight>
+bool HubLabelsRouter<Weight>::Deserialise(const proto::graph::Router& proto_router) {
+    const auto& proto_labels = proto_router.labels();
+    const size_t vertex_count = graph_.GetVertexCount();
+    const auto deserialise_labels = [this, vertex_count](const auto& offsets, const auto& hubs,
+                                                         const auto& weights, const auto& edges) {
+        if (static_cast<size_t>(offsets.size()) != vertex_count + 1
+                || hubs.size() != weights.size() || hubs.size() != edges.size()
+                || !detail::IsValidOffsets(offsets, static_cast<size_t>(hubs.size()))
+                || std::any_of(hubs.begin(), hubs.end(), [vertex_count](uint32_t hub) {
+                       return hub >= vertex_count;
+                   })
+                || std::any_of(edges.begin(), edges.end(), [this](uint64_t edge) {
+                       return edge != 0 && !graph_.HasEdge(edge - 1);
+                   })) {
+            throw std::invalid_argument("Hub labels do not match the graph");
+        }
+        // Слияние меток полагается на строгий порядок хабов в метке вершины
+        for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+            const auto begin = hubs.begin() + static_cast<int>(offsets[static_cast<int>(vertex)]);
+            const auto end = hubs.begin() + static_cast<int>(offsets[static_cast<int>(vertex + 1)]);
+            if (std::adjacent_find(begin, end, std::greater_equal<uint32_t>()) != end) {
+                throw std::invalid_argument("Hub labels do not match the graph");
+            }
+        }
+        Labels labels;
+        labels.offsets.assign(offsets.begin(), offsets.end());
+        labels.hubs.assign(hubs.begin(), hubs.end());
+        labels.weights.assign(weights.begin(), weights.end());
+        labels.edges.reserve(static_cast<size_t>(edges.size()));
+        for (const uint64_t edge : edges) {
+            labels.edges.push_back(edge == 0 ? NO_ID : static_cast<CompactId>(edge - 1));
+        }
+        return labels;
+    };
+
+    forward_labels_ = deserialise_labels(proto_labels.forward_offsets(), proto_labels.forward_hubs(),
+                                         proto_labels.forward_weights(), proto_labels.forward_edges());
+    backward_labels_ = deserialise_labels(proto_labels.backward_offsets(), proto_labels.backward_hubs(),
+                                          proto_labels.backward_weights(), proto_labels.backward_edges());
     return true;
 }
 
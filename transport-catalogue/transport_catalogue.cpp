@@ -1,40 +1,42 @@
 #include "transport_catalogue.h"
 
-#include <unordered_set>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
 
 void TransportCatalogue::AddBus(const std::string_view bus_name,
                                 const std::vector<std::string_view>& bus_stops,
                                 bool is_roudtrip) {
     std::vector<StopPtrConst> v_s;
     v_s.reserve(bus_stops.size());
-    std::unordered_set<std::string_view> unique_stops;
     for (std::string_view name_stop : bus_stops) {
-        StopPtrConst stop = m_names_stops.at(name_stop);
-        v_s.emplace_back(stop);
-        unique_stops.emplace(stop->name);
+        v_s.emplace_back(&m_dqstops[GetStopId(name_stop)]);
     }
 
-    std::string_view prev_stop_name {v_s.front()->name};
+    std::vector<StopId> unique_stops;
+    unique_stops.reserve(v_s.size());
+    for (const StopPtrConst stop : v_s) {
+        unique_stops.push_back(stop->id);
+    }
+    std::sort(unique_stops.begin(), unique_stops.end());
+    const size_t unique_count {static_cast<size_t>(
+                std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin())};
+
     int length {0};
     for (auto it = v_s.cbegin() + 1; it != v_s.cend(); it++) {
-        const std::string_view current_stop_name {(*it)->name};
-        length += GetDistance(prev_stop_name, current_stop_name);
-        prev_stop_name = current_stop_name;
+        length += GetDistance((*std::prev(it))->id, (*it)->id);
     }
 
-    BusPtrConst bus {EmplaceBus({std::string(bus_name),
-                                 std::move(v_s),
-                                 unique_stops.size(),
-                                 length,
-                                 is_roudtrip})};
-    for (const auto & stop_name : unique_stops) {
-        m_stop_to_buses[stop_name].insert(bus->name);
-    }
+    EmplaceBus({std::string(bus_name),
+                std::move(v_s),
+                unique_count,
+                length,
+                is_roudtrip});
 }
 
 BusPtrConst TransportCatalogue::EmplaceBus(Bus&& bus) {
+    bus.id = static_cast<BusId>(m_dqbuses.size());
     BusPtrConst bus_ptr = &m_dqbuses.emplace_back(std::move(bus));
-    m_names_buses.emplace(bus_ptr->name, bus_ptr);
     return bus_ptr;
 }
 
@@ -42,6 +44,66 @@ void TransportCatalogue::AddBuses(const std::vector<BusData>& buses) {
     for (const BusData& bd : buses) {
         AddBus(bd.name, bd.stops, bd.is_roundtrip);
     }
+    IndexStopBuses();
+    IndexBusNames();
+}
+
+void TransportCatalogue::IndexStopNames() {
+    std::vector<std::string_view> names;
+    names.reserve(m_dqstops.size());
+    for (const Stop& stop : m_dqstops) {
+        names.push_back(stop.name);
+    }
+    m_stop_names.Build(names);
+}
+
+void TransportCatalogue::IndexBusNames() {
+    std::vector<std::string_view> names;
+    names.reserve(m_dqbuses.size());
+    for (const Bus& bus : m_dqbuses) {
+        names.push_back(bus.name);
+    }
+    m_bus_names.Build(names);
+}
+
+void TransportCatalogue::IndexStopBuses() {
+    std::vector<BusId> buses_by_name(m_dqbuses.size());
+    for (BusId bus_id {0}; bus_id < buses_by_name.size(); ++bus_id) {
+        buses_by_name[bus_id] = bus_id;
+    }
+    std::sort(buses_by_name.begin(), buses_by_name.end(), [this](BusId lhs, BusId rhs) {
+        return m_dqbuses[lhs].name < m_dqbuses[rhs].name;
+    });
+
+    // Автобус попадает в список остановки один раз, даже если
+    // проезжает её несколько раз
+    constexpr BusId NO_BUS {std::numeric_limits<BusId>::max()};
+    std::vector<BusId> last_bus(m_dqstops.size(), NO_BUS);
+    m_stop_buses_offsets.assign(m_dqstops.size() + 1, 0);
+    for (const BusId bus_id : buses_by_name) {
+        for (const StopPtrConst stop : m_dqbuses[bus_id].stops) {
+            if (last_bus[stop->id] != bus_id) {
+                last_bus[stop->id] = bus_id;
+                ++m_stop_buses_offsets[stop->id + 1];
+            }
+        }
+    }
+    for (size_t stop_id {0}; stop_id < m_dqstops.size(); ++stop_id) {
+        m_stop_buses_offsets[stop_id + 1] += m_stop_buses_offsets[stop_id];
+    }
+
+    // Автобусы обходятся по названию, поэтому списки остановок сразу упорядочены
+    m_stop_buses.resize(m_stop_buses_offsets.back());
+    std::vector<size_t> positions(m_stop_buses_offsets.begin(), m_stop_buses_offsets.end() - 1);
+    last_bus.assign(m_dqstops.size(), NO_BUS);
+    for (const BusId bus_id : buses_by_name) {
+        for (const StopPtrConst stop : m_dqbuses[bus_id].stops) {
+            if (last_bus[stop->id] != bus_id) {
+                last_bus[stop->id] = bus_id;
+                m_stop_buses[positions[stop->id]++] = bus_id;
+            }
+        }
+    }
 }
 
 void TransportCatalogue::AddStop(std::string_view name, const geo::Coordinates& c) {
@@ -49,78 +111,104 @@ void TransportCatalogue::AddStop(std::string_view name, const geo::Coordinates&
 }
 
 StopPtrConst TransportCatalogue::EmplaceStop(Stop&& stop) {
+    stop.id = static_cast<StopId>(m_dqstops.size());
     StopPtrConst stop_ptr = &m_dqstops.emplace_back(std::move(stop));
-    m_names_stops.emplace(stop_ptr->name, stop_ptr);
     return stop_ptr;
 }
 
 void TransportCatalogue::AddStops(const std::vector<StopData>& stops) {
+    size_t distances_count {0};
     for (const StopData& sd: stops) {
         AddStop(sd.name, sd.coordinates);
+        distances_count += sd.adjacent.size();
     }
+    IndexStopNames();
+    m_stops_distance.Reserve(distances_count);
     for (const StopData& sd : stops) {
+        const StopId from {GetStopId(sd.name)};
         for (const auto& [other, distance] : sd.adjacent) {
-            SetDistance(sd.name, other, distance);
+            SetDistance(from, GetStopId(other), distance);
         }
     }
 }
 
-void TransportCatalogue::SetDistance(std::string_view name,
-                                     std::string_view other,
-                                     int distance) {
-    m_stops_distance[{name, other}] = distance;
+void TransportCatalogue::SetDistance(StopId from, StopId to, int distance) {
+    m_stops_distance.Set(from, to, distance);
 }
 
-int TransportCatalogue::GetDistance(std::string_view name,
-                                    std::string_view other) const {
-    PairStops key {name, other};
-    if (m_stops_distance.count(key) > 0) {
-        // Точно известно расстояние от предыдущей до текущей остановки
-        return m_stops_distance.at(key);
+int TransportCatalogue::GetDistance(StopId from, StopId to) const {
+    // Если расстояние в эту сторону не задано, таблица
+    // возвращает расстояние в обратную сторону
+    if (const auto distance {m_stops_distance.Find(from, to)}) {
+        return *distance;
     }
-    // Расстояние не задано, считаем равным от текущей до предыдущей
-    return m_stops_distance.at({other, name});
-
+    throw std::out_of_range("Distance between stops is not set");
 }
 
-std::unique_ptr<Info> TransportCatalogue::GetBusInfo(std::string_view name) const
+Info TransportCatalogue::GetBusInfo(std::string_view name) const
 {
-    if (m_names_buses.count(name) == 0) {
-        return std::make_unique<ErrorInfo>();
+    const auto bus_id {FindBusId(name)};
+    if (!bus_id) {
+        return ErrorInfo{};
     }
 
-    const Bus* bus_ptr {m_names_buses.at(name)};
-    return std::make_unique<BusInfo>(
-        bus_ptr->name,
-        bus_ptr->stops.size(),
-        bus_ptr->num_unique,
-        bus_ptr->geo_length,
-        bus_ptr->route_length);
+    const Bus& bus {m_dqbuses[*bus_id]};
+    return BusInfo(
+        bus.name,
+        bus.stops.size(),
+        bus.num_unique,
+        bus.geo_length,
+        bus.route_length);
 }
 
-std::unique_ptr<Info> TransportCatalogue::GetStopInfo(std::string_view name) const
+Info TransportCatalogue::GetStopInfo(std::string_view name) const
 {
-    if (m_names_stops.count(name) == 0) {
-        return std::make_unique<ErrorInfo>();
+    const auto stop_id {FindStopId(name)};
+    if (!stop_id) {
+        return ErrorInfo{};
     }
 
-    if (m_stop_to_buses.count(name) == 0) {
-        return std::make_unique<StopInfo>(name);
-    }
+    return StopInfo(m_dqstops[*stop_id].name, m_dqbuses, GetStopBuses(*stop_id));
+}
 
-    return std::make_unique<StopInfo>(name, m_stop_to_buses.find(name)->second);
+StopInfo::BusIds TransportCatalogue::GetStopBuses(StopId stop_id) const
+{
+    const BusId* const data {m_stop_buses.data()};
+    return {data + m_stop_buses_offsets[stop_id], data + m_stop_buses_offsets[stop_id + 1]};
 }
 
 BusPtrConst TransportCatalogue::GetBus(std::string_view name) const
 {
-    if (m_names_buses.count(name) == 0) return nullptr;
-    return m_names_buses.at(name);
+    const auto bus_id {FindBusId(name)};
+    return bus_id ? &m_dqbuses[*bus_id] : nullptr;
 }
 
 StopPtrConst TransportCatalogue::GetStop(std::string_view name) const
 {
-    if (m_names_stops.count(name) == 0) return nullptr;
-    return m_names_stops.at(name);
+    const auto stop_id {FindStopId(name)};
+    return stop_id ? &m_dqstops[*stop_id] : nullptr;
+}
+
+std::optional<StopId> TransportCatalogue::FindStopId(std::string_view name) const
+{
+    return m_stop_names.Find(name, [this](StopId id) -> std::string_view {
+        return m_dqstops[id].name;
+    });
+}
+
+std::optional<BusId> TransportCatalogue::FindBusId(std::string_view name) const
+{
+    return m_bus_names.Find(name, [this](BusId id) -> std::string_view {
+        return m_dqbuses[id].name;
+    });
+}
+
+StopId TransportCatalogue::GetStopId(std::string_view name) const
+{
+    if (const auto stop_id {FindStopId(name)}) {
+        return *stop_id;
+    }
+    throw std::out_of_range("Unknown stop");
 }
 
 const std::deque<Bus>& TransportCatalogue::GetBuses() const
@@ -133,12 +221,12 @@ const std::deque<Stop>& TransportCatalogue::GetStops() const
     return m_dqstops;
 }
 
-std::unique_ptr<Info> BusQuery::Request(const TransportCatalogue& catalogue) const
+Info BusQuery::Request(const TransportCatalogue& catalogue) const
 {
     return catalogue.GetBusInfo(name);
 }
 
-std::unique_ptr<Info> StopQuery::Request(const TransportCatalogue& catalogue) const
+Info StopQuery::Request(const TransportCatalogue& catalogue) const
 {
     return catalogue.GetStopInfo(name);
 }
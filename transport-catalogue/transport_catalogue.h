@@ -1,43 +1,48 @@
 #pragma once
 
+#include "distance_table.h"
 #include "domain.h"
+#include "name_index.h"
 
 #include <transport_catalogue.pb.h>
 
 #include <deque>
-#include <set>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <variant>
 #include <vector>
-#include <unordered_map>
 
+// Остановки и автобусы получают номера StopId и BusId при добавлении.
+// Внутренние индексы каталога построены по номерам, а названия
+// переводятся в номера только на входе запросов
 class TransportCatalogue
 {
 public:
-    void AddBus(const std::string_view bus_name,
-                const std::vector<std::string_view>& bus_stops,
-                bool is_roundtrip = false);
-    BusPtrConst EmplaceBus(Bus&& bus);
+    // Добавляет автобусы и перестраивает индексы автобусов остановок и названий автобусов
     void AddBuses(const std::vector<BusData>& buses);
 
-    void AddStop(std::string_view name, const geo::Coordinates& c);
-    StopPtrConst EmplaceStop(Stop&& stop);
-
+    // Добавляет остановки и строит индекс их названий
     void AddStops(const std::vector<StopData>& stops);
 
-    void SetDistance(std::string_view name,
-                     std::string_view other, int distance);
+    void SetDistance(StopId from, StopId to, int distance);
 
-    int GetDistance(std::string_view name,
-                    std::string_view other) const;
+    int GetDistance(StopId from, StopId to) const;
 
-    std::unique_ptr<Info> GetBusInfo(std::string_view name) const;
-    std::unique_ptr<Info> GetStopInfo(std::string_view name) const;
+    Info GetBusInfo(std::string_view name) const;
+    Info GetStopInfo(std::string_view name) const;
 
     BusPtrConst GetBus(std::string_view name) const;
     StopPtrConst GetStop(std::string_view name) const;
 
+    // Автобусы остановки, упорядоченные по названию
+    StopInfo::BusIds GetStopBuses(StopId stop_id) const;
+
+    std::optional<StopId> FindStopId(std::string_view name) const;
+    std::optional<BusId> FindBusId(std::string_view name) const;
+    // Бросает std::out_of_range для неизвестной остановки
+    StopId GetStopId(std::string_view name) const;
+
     const std::deque<Bus>& GetBuses() const;
     const std::deque<Stop>& GetStops() const;
 
@@ -45,22 +50,37 @@ public:
     bool Deserialize(const proto::TransportCatalogue& proto_catalogue);
 
 private:
+    StopPtrConst EmplaceStop(Stop&& stop);
+    BusPtrConst EmplaceBus(Bus&& bus);
+
+    void AddStop(std::string_view name, const geo::Coordinates& c);
+    void AddBus(const std::string_view bus_name,
+                const std::vector<std::string_view>& bus_stops,
+                bool is_roundtrip = false);
+
+    void IndexStopBuses();
+    void IndexStopNames();
+    void IndexBusNames();
+
     std::deque<Stop> m_dqstops;
-    std::unordered_map<std::string_view, StopPtrConst> m_names_stops;
+    NameIndex m_stop_names;
     std::deque<Bus> m_dqbuses;
-    std::unordered_map<std::string_view, BusPtrConst> m_names_buses;
-    std::unordered_map<std::string_view, std::set<std::string_view>> m_stop_to_buses;
-    std::unordered_map<PairStops, int, PairStopsHasher> m_stops_distance;
+    NameIndex m_bus_names;
+    // Автобусы остановки s в форме CSR занимают отрезок
+    // [m_stop_buses_offsets[s], m_stop_buses_offsets[s + 1]) массива m_stop_buses
+    std::vector<size_t> m_stop_buses_offsets;
+    std::vector<BusId> m_stop_buses;
+    DistanceTable m_stops_distance;
 };
 
 struct BusQuery {
     int request_id;
     std::string name;
-    std::unique_ptr<Info> Request(const TransportCatalogue& catalogue) const;
+    Info Request(const TransportCatalogue& catalogue) const;
 };
 
 struct StopQuery {
     int request_id;
     std::string name;
-    std::unique_ptr<Info> Request(const TransportCatalogue& catalogue) const;
+    Info Request(const TransportCatalogue& catalogue) const;
 };
@@ -1,5 +1,7 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <optional>
 #include <string_view>
 
 namespace transport {
@@ -11,52 +13,245 @@ Router::Router(const TransportCatalogue& catalogue,
 {}
 
 void Router::BuildGraph() {
+    MakeCache();
+    if (m_settings.router_type == RouterType::Raptor) {
+        // RAPTOR работает прямо по маршрутам автобусов, граф ему не нужен
+        m_raptor = std::make_unique<RaptorRouter>(m_transport_catalogue, m_settings);
+        return;
+    }
     const auto& stops {m_transport_catalogue.GetStops()};
     m_graph = std::make_unique<graph::DirectedWeightedGraph<double>>(2 * stops.size());
     BuildVertices(stops);
     BuildEdges(m_transport_catalogue.GetBuses());
-    m_router = std::make_unique<graph::Router<double>>(*m_graph);
+    FreezeGraph();
+    m_router = MakeRouter();
+}
+
+bool Router::IsReady() const {
+    return m_router || m_raptor;
+}
+
+size_t Router::GetIndexSize() const {
+    return m_router ? m_router->GetIndexSize() : 0;
+}
+
+std::optional<RouteCache::Stats> Router::GetCacheStats() const {
+    if (!m_cache) {
+        return std::nullopt;
+    }
+    return m_cache->GetStats();
+}
+
+namespace {
+
+RouteCache::Value MakeCacheValue(const Info& info) {
+    if (const auto route {std::get_if<RouteInfo>(&info)}) {
+        return std::make_shared<const RouteInfo>(*route);
+    }
+    return nullptr;
+}
+
+Info MakeInfo(const RouteCache::Value& value) {
+    if (value) {
+        return RouteInfo(*value);
+    }
+    return ErrorInfo{};
 }
 
-std::unique_ptr<Info>
+} // namespace
+
+Info
 Router::BuildRoute(std::string_view from,
                    std::string_view to) const
 {
-    const graph::VertexId& vertex_from {m_name_to_vertex_wait.at(from)};
-    const graph::VertexId& vertex_to {m_name_to_vertex_wait.at(to)};
+    if (!m_cache) {
+        return FindRoute(from, to);
+    }
+    const RouteCache::Key key {m_transport_catalogue.GetStopId(from),
+                               m_transport_catalogue.GetStopId(to)};
+    if (const auto cached {m_cache->Find(key)}) {
+        return MakeInfo(*cached);
+    }
+    auto route {FindRoute(from, to)};
+    m_cache->Insert(key, MakeCacheValue(route));
+    return route;
+}
+
+std::vector<Info>
+Router::BuildRoutes(std::string_view from,
+                    const std::vector<std::string_view>& to) const
+{
+    if (!m_cache) {
+        return FindRoutes(from, to);
+    }
+    const StopId stop_from {m_transport_catalogue.GetStopId(from)};
+    std::vector<Info> routes(to.size());
+    // Ищутся только цели, которых нет в кэше
+    std::vector<std::string_view> missed;
+    std::vector<size_t> missed_positions;
+    for (size_t i {0}; i < to.size(); ++i) {
+        if (const auto cached {m_cache->Find({stop_from, m_transport_catalogue.GetStopId(to[i])})}) {
+            routes[i] = MakeInfo(*cached);
+        } else {
+            missed.push_back(to[i]);
+            missed_positions.push_back(i);
+        }
+    }
+    if (missed.empty()) {
+        return routes;
+    }
+    auto found {FindRoutes(from, missed)};
+    for (size_t i {0}; i < missed.size(); ++i) {
+        m_cache->Insert({stop_from, m_transport_catalogue.GetStopId(missed[i])}, MakeCacheValue(found[i]));
+        routes[missed_positions[i]] = std::move(found[i]);
+    }
+    return routes;
+}
+
+RouteMatrixInfo::TotalTimes
+Router::BuildTimeMatrix(const std::vector<std::string_view>& from,
+                        const std::vector<std::string_view>& to) const
+{
+    RouteMatrixInfo::TotalTimes total_times;
+    if (m_raptor) {
+        total_times.reserve(from.size());
+        for (const std::string_view origin : from) {
+            total_times.push_back(m_raptor->BuildTimes(origin, to));
+        }
+        return total_times;
+    }
+    const auto to_vertices = [this](const std::vector<std::string_view>& names) {
+        std::vector<graph::VertexId> vertices;
+        vertices.reserve(names.size());
+        for (const std::string_view name : names) {
+            vertices.push_back(GetWaitVertex(name));
+        }
+        return vertices;
+    };
+    return m_router->BuildWeightMatrix(to_vertices(from), to_vertices(to));
+}
+
+std::vector<ReachableInfo::Item>
+Router::BuildReachable(std::string_view from, double max_time) const
+{
+    if (m_raptor) {
+        return m_raptor->BuildReachable(from, max_time);
+    }
+    // Время до остановки — вес пути до её вершины ожидания
+    std::vector<ReachableInfo::Item> reachable;
+    const auto& stops {m_transport_catalogue.GetStops()};
+    for (const auto& [vertex, weight] : graph::FindReachable(*m_graph, GetWaitVertex(from), max_time)) {
+        const StopId stop_id {m_vertex_to_stop[vertex]};
+        if (m_stop_to_vertex_wait[stop_id] == vertex) {
+            reachable.push_back({stops[stop_id].name, weight});
+        }
+    }
+    return reachable;
+}
 
-    auto route_info = m_router->BuildRoute(vertex_from, vertex_to);
+Info
+Router::FindRoute(std::string_view from,
+                  std::string_view to) const
+{
+    if (m_raptor) {
+        return m_raptor->BuildRoute(from, to);
+    }
+    const graph::VertexId& vertex_from {GetWaitVertex(from)};
+    const graph::VertexId& vertex_to {GetWaitVertex(to)};
+
+    return MakeRouteInfo(m_router->BuildRoute(vertex_from, vertex_to));
+}
+
+std::vector<Info>
+Router::FindRoutes(std::string_view from,
+                   const std::vector<std::string_view>& to) const
+{
+    if (m_raptor) {
+        return m_raptor->BuildRoutes(from, to);
+    }
+    std::vector<graph::VertexId> vertices_to;
+    vertices_to.reserve(to.size());
+    for (const std::string_view name : to) {
+        vertices_to.push_back(GetWaitVertex(name));
+    }
+
+    std::vector<Info> routes;
+    routes.reserve(to.size());
+    for (const auto& route_info : m_router->BuildRoutes(GetWaitVertex(from),
+                                                        vertices_to)) {
+        routes.push_back(MakeRouteInfo(route_info));
+    }
+    return routes;
+}
+
+graph::VertexId Router::GetWaitVertex(std::string_view name) const {
+    return m_stop_to_vertex_wait[m_transport_catalogue.GetStopId(name)];
+}
+
+void Router::MakeCache() {
+    if (m_settings.cache_capacity > 0) {
+        m_cache = std::make_unique<RouteCache>(m_settings.cache_capacity);
+    } else {
+        m_cache.reset();
+    }
+}
+
+Info
+Router::MakeRouteInfo(const std::optional<graph::RouterBase<double>::RouteInfo>& route_info) const
+{
     if (route_info.has_value()) {
         std::vector<RouteInfo::RouteItem> items;
         items.reserve(route_info->edges.size());
         for (const auto& edge_id : route_info->edges) {
             items.emplace_back([this](graph::EdgeId id) {
-                const auto& edge {m_graph->GetEdge(id)};
-                const auto& data {m_edge_to_data.at(id)};
+                const auto edge {m_graph->GetEdge(id)};
+                const auto& buses {m_transport_catalogue.GetBuses()};
+                if (const auto line_edge {m_graph->GetLineEdge(id)}) {
+                    const size_t span_count {line_edge->to_position - line_edge->from_position};
+                    return RouteInfo::RouteItem{buses[m_line_to_bus[line_edge->line]].name,
+                                                false, edge.weight, span_count};
+                }
+                const auto& data {m_edge_to_data[id]};
                 if (data.is_wait) {
-                    return RouteInfo::RouteItem{m_vertex_to_name.at(edge.from), data.is_wait, edge.weight};
+                    const auto& stop {m_transport_catalogue.GetStops()[m_vertex_to_stop[edge.from]]};
+                    return RouteInfo::RouteItem{stop.name, data.is_wait, edge.weight};
                 }
-                return RouteInfo::RouteItem{data.bus, data.is_wait, edge.weight, data.span_count};
+                return RouteInfo::RouteItem{buses[data.bus].name, data.is_wait, edge.weight, data.span_count};
             } (edge_id) );
         }
-        return std::make_unique<RouteInfo>(route_info->weight,
-                                           std::move(items));
+        return RouteInfo(route_info->weight,
+                          std::move(items));
     }
-    return std::make_unique<ErrorInfo>();
+    return ErrorInfo{};
 }
 
 void Router::BuildVertices(const std::deque<Stop>& stops) {
-    graph::VertexId id {0};
-    for (const auto & stop : stops) {
-        const auto & wait_vertex {m_vertex_to_name.emplace(id++, stop.name).first};
-        m_name_to_vertex_wait.emplace(wait_vertex->second, wait_vertex->first);
-        const auto & go_vertex {m_vertex_to_name.emplace(id++, stop.name).first};
-        m_name_to_vertex_go.emplace(go_vertex->second, go_vertex->first);
+    m_vertex_to_stop.reserve(2 * stops.size());
+    for (const auto& stop : stops) {
+        m_vertex_to_stop.push_back(stop.id);
+        m_vertex_to_stop.push_back(stop.id);
+    }
+    IndexStopVertices();
+}
+
+void Router::IndexStopVertices() {
+    const size_t stops_count {m_transport_catalogue.GetStops().size()};
+    m_stop_to_vertex_wait.assign(stops_count, 0);
+    m_stop_to_vertex_go.assign(stops_count, 0);
+    std::vector<bool> has_wait(stops_count, false);
+    for (graph::VertexId vertex {0}; vertex < m_vertex_to_stop.size(); ++vertex) {
+        const StopId stop_id {m_vertex_to_stop[vertex]};
+        if (!has_wait[stop_id]) {
+            m_stop_to_vertex_wait[stop_id] = vertex;
+            has_wait[stop_id] = true;
+        } else {
+            m_stop_to_vertex_go[stop_id] = vertex;
+        }
     }
 }
 
 void Router::BuildEdges(const std::deque<Bus>& buses) {
-    for (const auto & bus : buses) {
+    for (const auto& bus : buses) {
         BuildEdgesForBus(bus);
     }
 }
@@ -70,21 +265,130 @@ void Router::BuildEdgesForBus(const Bus& bus) {
     }(bus.is_roundtrip);
 
     for (auto it {first}; it != last; it++) {
-        const auto& from_wait {m_name_to_vertex_wait.at((*it)->name)};
-        const auto& to_go {m_name_to_vertex_go.at((*it)->name)};
-        MakeEdge(from_wait, to_go, m_settings.bus_wait_time, {bus.name, 0, true});
+        const graph::VertexId from_wait {m_stop_to_vertex_wait[(*it)->id]};
+        const graph::VertexId to_go {m_stop_to_vertex_go[(*it)->id]};
+        MakeEdge(from_wait, to_go, m_settings.bus_wait_time, {bus.id, 0, true});
     }
 
-    BuildEdgesForBusStops(first, stops.cend(), bus.name);
-    if (bus.is_roundtrip) return;
-    BuildEdgesForBusStops(std::next(first, stops.size() / 2), stops.cend(), bus.name);
+    BuildLineForBus(bus);
+}
+
+void Router::BuildLineForBus(const Bus& bus) {
+    // Линия идёт по всей последовательности остановок, поэтому для
+    // некольцевого маршрута покрывает и поездки обратного направления
+    std::vector<graph::VertexId> from_go;
+    std::vector<graph::VertexId> to_wait;
+    std::vector<double> prefix_weights;
+    from_go.reserve(bus.stops.size());
+    to_wait.reserve(bus.stops.size());
+    prefix_weights.reserve(bus.stops.size());
+
+    double distance {0.0};
+    for (size_t i {0}; i < bus.stops.size(); ++i) {
+        if (i > 0) {
+            distance += m_transport_catalogue.GetDistance(bus.stops[i - 1]->id, bus.stops[i]->id);
+        }
+        from_go.push_back(m_stop_to_vertex_go[bus.stops[i]->id]);
+        to_wait.push_back(m_stop_to_vertex_wait[bus.stops[i]->id]);
+        prefix_weights.push_back(CalculateWeight(distance));
+        m_line_distances.push_back(distance);
+    }
+
+    m_graph->AddLine(std::move(from_go), std::move(to_wait), std::move(prefix_weights));
+    m_line_to_bus.push_back(bus.id);
+}
+
+void Router::FreezeGraph() {
+    const std::vector<graph::EdgeId> new_ids {m_graph->Freeze()};
+    std::vector<EdgeData> edge_to_data(m_edge_to_data.size());
+    for (graph::EdgeId id {0}; id < m_edge_to_data.size(); ++id) {
+        edge_to_data[new_ids[id]] = m_edge_to_data[id];
+    }
+    m_edge_to_data = std::move(edge_to_data);
+}
+
+bool Router::ApplyWeightSettings(const RoutingSettings& settings) {
+    const bool is_changed {settings.bus_wait_time != m_settings.bus_wait_time
+                           || settings.bus_velocity != m_settings.bus_velocity};
+    m_settings.bus_wait_time = settings.bus_wait_time;
+    m_settings.bus_velocity = settings.bus_velocity;
+    m_settings.thread_count = settings.thread_count;
+    return is_changed;
+}
+
+void Router::ReweightGraph() {
+    // Явные рёбра графа — только рёбра ожидания
+    const std::vector<double> edge_weights(m_edge_to_data.size(),
+                                           static_cast<double>(m_settings.bus_wait_time));
+    std::vector<double> prefix_weights;
+    prefix_weights.reserve(m_line_distances.size());
+    for (const double distance : m_line_distances) {
+        prefix_weights.push_back(CalculateWeight(distance));
+    }
+    m_graph->Reweight(edge_weights, std::move(prefix_weights));
 }
 
 inline double Router::CalculateWeight(double distance) const {
-    constexpr int meters_in_kilometer {1000};
-    constexpr int minutes_in_hour {60};
-    return (minutes_in_hour * distance) /
-           (meters_in_kilometer * m_settings.bus_velocity);
+    return m_settings.GetRideTime(distance);
+}
+
+std::unique_ptr<graph::RouterBase<double>> Router::MakeRouter() const {
+    switch (m_settings.router_type) {
+    case RouterType::Dijkstra:
+        return std::make_unique<graph::DijkstraRouter<double>>(*m_graph);
+    case RouterType::AStar:
+        return std::make_unique<graph::AStarRouter<double>>(*m_graph, MakeGeoHeuristic());
+    case RouterType::Bidirectional:
+        return std::make_unique<graph::BidirectionalDijkstraRouter<double>>(*m_graph);
+    case RouterType::ContractionHierarchy:
+        return std::make_unique<graph::ContractionHierarchyRouter<double>>(*m_graph);
+    case RouterType::HubLabels:
+        return std::make_unique<graph::HubLabelsRouter<double>>(*m_graph);
+    case RouterType::AllPairs:
+    case RouterType::Raptor:
+        break;
+    }
+    // Маршруты запрашиваются только между вершинами ожидания,
+    // поэтому таблица строится лишь для них
+    return std::make_unique<graph::Router<double>>(*m_graph,
+                                                   m_stop_to_vertex_wait,
+                                                   m_settings.thread_count);
+}
+
+graph::AStarRouter<double>::Heuristic Router::MakeGeoHeuristic() const {
+    // Любое ребро поездки проходит по соседним остановкам маршрута,
+    // поэтому его вес не меньше расстояния по прямой, умноженного на
+    // наименьшее отношение дорожного расстояния к географическому
+    std::optional<double> min_ratio;
+    for (const auto& bus : m_transport_catalogue.GetBuses()) {
+        for (size_t i {1}; i < bus.stops.size(); ++i) {
+            const StopPtrConst from {bus.stops[i - 1]};
+            const StopPtrConst to {bus.stops[i]};
+            const double geo_distance {geo::ComputeDistance(from->coord, to->coord)};
+            if (geo_distance <= 0.0) continue;
+            const double ratio {m_transport_catalogue.GetDistance(from->id, to->id) / geo_distance};
+            if (!min_ratio || ratio < *min_ratio) {
+                min_ratio = ratio;
+            }
+        }
+    }
+    const double ride_time_per_meter {CalculateWeight(std::max(min_ratio.value_or(0.0), 0.0))};
+
+    std::vector<geo::Coordinates> coordinates(m_graph->GetVertexCount());
+    for (graph::VertexId vertex {0}; vertex < m_vertex_to_stop.size(); ++vertex) {
+        coordinates[vertex] = m_transport_catalogue.GetStops()[m_vertex_to_stop[vertex]].coord;
+    }
+
+    return [ride_time_per_meter, coordinates = std::move(coordinates)]
+            (graph::VertexId vertex, graph::VertexId target) {
+        // ComputeDistance считает через acos и ошибается на доли метра,
+        // поэтому оценка берётся с запасом, чтобы не превысить настоящий вес
+        constexpr double relative_margin {1e-3};
+        constexpr double absolute_margin {1.0};
+        const double distance {geo::ComputeDistance(coordinates[vertex], coordinates[target])};
+        const double lower_bound {distance * (1.0 - relative_margin) - absolute_margin};
+        return ride_time_per_meter * std::max(lower_bound, 0.0);
+    };
 }
 
 graph::EdgeId Router::MakeEdge(graph::VertexId from,
@@ -93,7 +397,8 @@ graph::EdgeId Router::MakeEdge(graph::VertexId from,
                                const EdgeData& data) {
     graph::EdgeId id = m_graph->AddEdge({from, to, weight});
 
-    m_edge_to_data[id] = data;
+    // До Freeze id явных рёбер идут подряд
+    m_edge_to_data.push_back(data);
     return id;
 }
 
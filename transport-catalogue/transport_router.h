@@ -1,14 +1,21 @@
 #pragma once
 
+#include "astar_router.h"
+#include "bidirectional_dijkstra_router.h"
+#include "contraction_hierarchy.h"
 #include "domain.h"
+#include "dijkstra_router.h"
 #include "graph.h"
+#include "hub_labels.h"
+#include "raptor_router.h"
+#include "route_cache.h"
 #include "router.h"
 #include "transport_catalogue.h"
 
 #include <transport_router.pb.h>
 
+#include <optional>
 #include <string_view>
-#include <unordered_map>
 
 namespace transport {
 
@@ -18,43 +25,82 @@ public:
     Router(const TransportCatalogue& catalogue, const RoutingSettings& settings);
 
     void BuildGraph();
+    bool IsReady() const;
+    // Объём предварительно вычисленных данных маршрутизатора в байтах
+    size_t GetIndexSize() const;
+    // Попадания и промахи кэша маршрутов, если кэш включён
+    std::optional<RouteCache::Stats> GetCacheStats() const;
 
-    std::unique_ptr<Info> BuildRoute(std::string_view from,
-                                     std::string_view to) const;
+    Info BuildRoute(std::string_view from,
+                    std::string_view to) const;
+
+    // Маршруты из одной остановки в несколько, по одному ответу на каждую цель
+    std::vector<Info> BuildRoutes(std::string_view from,
+                                  const std::vector<std::string_view>& to) const;
+
+    // Время в пути от каждой остановки from до каждой остановки to, без маршрутов
+    RouteMatrixInfo::TotalTimes BuildTimeMatrix(const std::vector<std::string_view>& from,
+                                                const std::vector<std::string_view>& to) const;
+
+    // Остановки, до которых можно доехать из from не дольше max_time, по возрастанию времени
+    std::vector<ReachableInfo::Item> BuildReachable(std::string_view from, double max_time) const;
 
     bool Serialize(proto::transport::Router& proto_router) const;
-    bool Deserialize(const proto::transport::Router& proto_router);
+    // Если в settings время ожидания или скорость отличаются от сохранённых,
+    // веса пересчитываются на сохранённом графе и строится только поиск
+    bool Deserialize(const proto::transport::Router& proto_router,
+                     const std::optional<RoutingSettings>& settings = std::nullopt);
 
 
 private:
     struct EdgeData {
-        std::string_view bus;
+        BusId bus {0};
         size_t span_count {0};
         bool is_wait {false};
     };
 
+    Info FindRoute(std::string_view from,
+                   std::string_view to) const;
+
+    std::vector<Info> FindRoutes(std::string_view from,
+                                 const std::vector<std::string_view>& to) const;
+
+    graph::VertexId GetWaitVertex(std::string_view name) const;
+
+    void MakeCache();
+
+    Info
+    MakeRouteInfo(const std::optional<graph::RouterBase<double>::RouteInfo>& route_info) const;
+
     void BuildVertices(const std::deque<Stop>& stops);
 
     void BuildEdges(const std::deque<Bus>& buses);
 
     void BuildEdgesForBus(const Bus& bus);
 
-    template<class Iterator>
-    void BuildEdgesForBusStops(Iterator begin, Iterator end, std::string_view bus) {
-        for (Iterator it {begin}; it != end; it++) {
-            double distance {0.0};
-            for (Iterator jt {std::next(it)}; jt != end; jt++) {
-                distance += m_transport_catalogue.GetDistance((*std::prev(jt))->name, (*jt)->name);
-                const auto& from_go {m_name_to_vertex_go.at((*it)->name)};
-                const auto& to_wait {m_name_to_vertex_wait.at((*jt)->name)};
-                const size_t span_count {static_cast<size_t>(std::distance(it, jt))};
-                MakeEdge(from_go, to_wait, CalculateWeight(distance), {bus, span_count});
-            }
-        }
-    }
+    // Рёбра поездок автобуса не хранятся: по остановкам маршрута и
+    // префиксным суммам времени граф получает их как неявные рёбра линии
+    void BuildLineForBus(const Bus& bus);
+
+    // Восстанавливает вершины ожидания и отправления остановок
+    void IndexStopVertices();
+
+    void FreezeGraph();
+
+    // Переносит из settings параметры весов, возвращает true, если они изменились
+    bool ApplyWeightSettings(const RoutingSettings& settings);
+
+    // Пересчитывает веса графа по текущим настройкам
+    void ReweightGraph();
 
     inline double CalculateWeight(double distance) const;
 
+    std::unique_ptr<graph::RouterBase<double>> MakeRouter() const;
+
+    // Эвристика A*: время поездки по прямой с наименьшим
+    // отношением дорожного расстояния к географическому
+    graph::AStarRouter<double>::Heuristic MakeGeoHeuristic() const;
+
     graph::EdgeId MakeEdge(graph::VertexId from,
                            graph::VertexId to,
                            double weight,
@@ -63,11 +109,21 @@ private:
     const TransportCatalogue& m_transport_catalogue;
     RoutingSettings m_settings;
     std::unique_ptr<graph::DirectedWeightedGraph<double>> m_graph {nullptr};
-    std::unique_ptr<graph::Router<double>> m_router {nullptr};
-    std::unordered_map<graph::VertexId, std::string_view> m_vertex_to_name;
-    std::unordered_map<std::string_view, graph::VertexId> m_name_to_vertex_wait;
-    std::unordered_map<std::string_view, graph::VertexId> m_name_to_vertex_go;
-    std::unordered_map<graph::EdgeId, EdgeData> m_edge_to_data;
+    std::unique_ptr<graph::RouterBase<double>> m_router {nullptr};
+    std::unique_ptr<RaptorRouter> m_raptor {nullptr};
+    // Номер остановки по вершине: у каждой остановки сначала
+    // идёт вершина ожидания, затем вершина отправления
+    std::vector<StopId> m_vertex_to_stop;
+    // Вершины ожидания и отправления по номеру остановки
+    std::vector<graph::VertexId> m_stop_to_vertex_wait;
+    std::vector<graph::VertexId> m_stop_to_vertex_go;
+    // Данные явных рёбер по id, номер автобуса по номеру линии
+    std::vector<EdgeData> m_edge_to_data;
+    std::vector<BusId> m_line_to_bus;
+    // Префиксные дорожные расстояния линий в порядке их позиций в графе
+    std::vector<double> m_line_distances;
+    // Пустой, если кэш отключён в настройках
+    std::unique_ptr<RouteCache> m_cache {nullptr};
 };
 
 }
@@ -76,8 +132,29 @@ struct RouteQuery {
     int request_id;
     std::string from;
     std::string to;
-    std::unique_ptr<Info> Request(const transport::Router& router) const
+    Info Request(const transport::Router& router) const
     {
         return router.BuildRoute(from, to);
     }
 };
+
+struct ReachableQuery {
+    int request_id;
+    std::string from;
+    double max_time;
+    Info Request(const transport::Router& router) const
+    {
+        return ReachableInfo(router.BuildReachable(from, max_time));
+    }
+};
+
+struct RouteMatrixQuery {
+    int request_id;
+    std::vector<std::string> from;
+    std::vector<std::string> to;
+    Info Request(const transport::Router& router) const
+    {
+        return RouteMatrixInfo(
+                    router.BuildTimeMatrix({from.begin(), from.end()}, {to.begin(), to.end()}));
+    }
+};